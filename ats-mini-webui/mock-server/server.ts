@@ -8,8 +8,16 @@ import memoryOptions from "./memoryOptions.json";
 import initialConfig from "./config.json";
 import configOptions from "./configOptions.json";
 
-let status = initialStatus;
+let status = {...initialStatus, doneId: 0, failedId: 0};
 let config = initialConfig;
+let requestId = 0;
+
+// Changes are applied right away, report the request as done
+const accepted = (res: ServerResponse<Connect.IncomingMessage>) => {
+  status.doneId = ++requestId;
+  res.statusCode = 202;
+  res.end(JSON.stringify({id: requestId}));
+}
 
 export const mockApi = (req: Connect.IncomingMessage, res: ServerResponse<Connect.IncomingMessage>) => {
   if (!req.url) {
@@ -38,7 +46,7 @@ export const mockApi = (req: Connect.IncomingMessage, res: ServerResponse<Connec
             status.agc = true;
             delete status.attenuation
           }
-          res.end(JSON.stringify(status));
+          accepted(res);
         } catch (error) {
           console.error(error)
           res.statusCode = 400;
@@ -61,7 +69,7 @@ export const mockApi = (req: Connect.IncomingMessage, res: ServerResponse<Connec
 
     } else if (req.method === 'POST') {
       if (req.url?.endsWith('/tune')) {
-        res.end()
+        accepted(res);
 
       } else if (req.url?.endsWith('/storeCurrent')) {
         let memoryIdxStr = req.url.substring(8);
@@ -110,7 +118,7 @@ export const mockApi = (req: Connect.IncomingMessage, res: ServerResponse<Connec
       req.on('end', () => {
         try {
           config = JSON.parse(body);
-          res.end(JSON.stringify(config));
+          accepted(res);
         } catch (error) {
           console.error(error)
           res.statusCode = 400;
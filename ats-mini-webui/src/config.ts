@@ -8,7 +8,8 @@ import {
   responseToJson,
   setCheckboxValue,
   setInputValue,
-  syncValues
+  syncValues,
+  waitForRequest
 } from "./utils";
 
 
@@ -20,6 +21,8 @@ const saveConfigApi = (config: Config) => {
     },
     body: JSON.stringify(config)
   })
+    .then(waitForRequest)
+    .then(() => fetch('/api/config'))
     .then(responseToJson)
     .then((updatedConfig: Config) => {
       window.scrollTo({top: 0, behavior: 'smooth'});
@@ -0,0 +1,93 @@
+import {byId} from "./utils";
+
+// Live screen mirror, see mirrorTickTime() in the firmware
+const RECONNECT_DELAY = 2000;
+
+const decodeTile = (
+  image: ImageData,
+  view: DataView,
+  pos: number,
+  end: number,
+  x0: number,
+  y0: number,
+  w: number
+) => {
+  let i = 0;
+
+  const putPixel = (color: number) => {
+    const offset = ((y0 + Math.floor(i / w)) * image.width + x0 + (i % w)) * 4;
+    image.data[offset] = ((color >> 11) & 0x1F) * 255 / 31;
+    image.data[offset + 1] = ((color >> 5) & 0x3F) * 255 / 63;
+    image.data[offset + 2] = (color & 0x1F) * 255 / 31;
+    image.data[offset + 3] = 255;
+    i++;
+  };
+
+  // PackBits: N < 128 is N + 1 literal pixels, otherwise a pixel repeated N - 126 times
+  while (pos < end) {
+    const n = view.getUint8(pos++);
+    if (n < 128) {
+      for (let j = 0; j <= n; j++, pos += 2) {
+        putPixel(view.getUint16(pos, true));
+      }
+    } else {
+      const color = view.getUint16(pos, true);
+      pos += 2;
+      for (let j = 0; j < n - 126; j++) {
+        putPixel(color);
+      }
+    }
+  }
+};
+
+const connect = (canvas: HTMLCanvasElement) => {
+  const context = canvas.getContext('2d');
+  if (!context) {
+    return;
+  }
+
+  let image: ImageData | null = null;
+  const socket = new WebSocket(`ws://${window.location.host}/ws/screen`);
+  socket.binaryType = 'arraybuffer';
+
+  socket.onmessage = (event: MessageEvent<ArrayBuffer>) => {
+    const view = new DataView(event.data);
+    const tile = view.getUint8(1);
+    const width = view.getUint16(2, true);
+    const height = view.getUint16(4, true);
+    const count = view.getUint16(6, true);
+
+    // Wait for a keyframe before drawing anything
+    if (view.getUint8(0) === 'K'.charCodeAt(0)) {
+      canvas.width = width;
+      canvas.height = height;
+      image = context.createImageData(width, height);
+    }
+    if (!image) {
+      return;
+    }
+
+    let pos = 8;
+    for (let t = 0; t < count; t++) {
+      const x0 = view.getUint8(pos) * tile;
+      const y0 = view.getUint8(pos + 1) * tile;
+      const length = view.getUint16(pos + 2, true);
+      pos += 4;
+      decodeTile(image, view, pos, pos + length, x0, y0, Math.min(tile, width - x0));
+      pos += length;
+    }
+
+    context.putImageData(image, 0, 0);
+  };
+
+  socket.onclose = () => {
+    setTimeout(() => connect(canvas), RECONNECT_DELAY);
+  };
+};
+
+document.addEventListener('DOMContentLoaded', () => {
+  const canvas = byId('screen') as HTMLCanvasElement;
+  if (canvas) {
+    connect(canvas);
+  }
+});
@@ -8,6 +8,8 @@ export interface Status {
   modeIdx: number;
   rssi: number;
   snr: number;
+  doneId: number;
+  failedId: number;
   battery: number;
   stepIdx: number;
   bandwidthIdx: number;
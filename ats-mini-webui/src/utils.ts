@@ -1,3 +1,5 @@
+import type {Status} from "./types";
+
 export const byId = (id: string) => document.getElementById(id);
 
 export const debounce = (func: () => void, timeout = 300) => {
@@ -18,6 +20,26 @@ export const responseToJson = async (response: Response) => {
   return response.json();
 }
 
+// Changes are applied by the receiver after responding, wait
+// until its status reports the request as done
+export const waitForRequest = async (response: Response, timeout = 5000) => {
+  const {id} = await responseToJson(response) as {id: number};
+  const start = Date.now();
+
+  while (Date.now() - start < timeout) {
+    const status: Status = await fetch('/api/status').then(responseToJson);
+    if (status.doneId >= id) {
+      if (status.failedId === id) {
+        throw new Error(`Request ${id} failed`);
+      }
+      return;
+    }
+    await new Promise(resolve => setTimeout(resolve, 100));
+  }
+
+  throw new Error(`Request ${id} timed out`);
+}
+
 export const downloadContent = (content: string, filename: string) => {
   const blob = new Blob([content], {
     type: 'application/json',
@@ -1,6 +1,7 @@
 #include "Common.h"
 #include "Themes.h"
 #include "Utils.h"
+#include "Perf.h"
 
 #define VBAT_MON  4                 // GPIO04 -- Battery Monitor PIN
 
@@ -10,6 +11,7 @@
 #define BATT_SOC_LEVEL2      3.780  // Battery SOC voltage for 50%
 #define BATT_SOC_LEVEL3      3.880  // Battery SOC voltage for 75%
 #define BATT_SOC_HYST_2      0.020  // Battery SOC hyteresis voltage divided by 2
+#define BATT_CHECK_TIME       1000  // Battery voltage measurement period (ms)
 
 // State machine used for battery state of charge (SOC) detection with
 // hysteresis (Default = Illegal state)
@@ -62,16 +64,40 @@ float batteryMonitor()
   return(batteryVolts);
 }
 
+//
+// Return last measured battery voltage
+//
+float batteryGetVolts()
+{
+  return(batteryVolts);
+}
+
+//
+// Tick battery time, periodically measuring battery voltage. Return
+// true if the displayed voltage or state has changed.
+//
+bool batteryTickTime()
+{
+  static uint32_t batteryTimer = 0;
+  uint8_t state = batteryState;
+  int volts = batteryVolts * 100;
+
+  if(millis() - batteryTimer < BATT_CHECK_TIME) return(false);
+  batteryTimer = millis();
+
+  batteryMonitor();
+  return(state != batteryState || volts != (int)(batteryVolts * 100));
+}
+
 //
 // Show last measured battery voltage and status at given screen
 // coordinates. Return true if voltage was drawn.
 //
 bool drawBattery(int x, int y)
 {
-  if(sleepOn()) return false;
+  PERF_RENDER(PERF_DRAW_BATTERY);
 
-  // Measure battery voltage and status
-  batteryMonitor();
+  if(sleepOn()) return false;
 
   // Set display information
   spr.drawRoundRect(x, y + 1, 28, 14, 3, TH.batt_border);
@@ -1,6 +1,14 @@
 #include "Common.h"
 #include "Button.h"
 
+//
+// Check if the encoder button is currently pressed (not debounced)
+//
+bool buttonPressed()
+{
+  return(digitalRead(ENCODER_PUSH_BUTTON) == LOW);
+}
+
 ButtonTracker::ButtonTracker() {
   reset();
 }
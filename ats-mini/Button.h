@@ -25,4 +25,7 @@ class ButtonTracker {
     unsigned long pressStartTime;
 };
 
+// Encoder button state, the only place reading its pin
+bool buttonPressed();
+
 #endif
@@ -0,0 +1,397 @@
+#include "Common.h"
+#include "Capture.h"
+
+#include <ESPAsyncWebServer.h>
+
+// Screen snapshot served over HTTP, one download at a time. The
+// snapshot is taken by the main loop, between frames.
+static uint16_t *captureSnapshot = 0;
+static volatile uint8_t captureState = CAPTURE_FREE;
+static volatile uint32_t captureTime = 0;     // Last download activity
+static uint32_t captureId = 0;                // Current download
+
+// Screen mirror clients and state
+static AsyncWebSocket mirrorWs("/ws/screen");
+static uint32_t *mirrorHashes = 0;
+static uint8_t *mirrorBuf = 0;
+static volatile bool mirrorKeyframe = true;
+static uint16_t mirrorInterval = MIRROR_MIN_INTERVAL;
+
+static inline void put16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+//
+// Create BMP header for a bottom-up RGB565 image, returning its size
+//
+size_t captureBmpHeader(uint8_t *buf, uint16_t width, uint16_t height)
+{
+  memset(buf, 0, CAPTURE_BMP_HEADER);
+
+  // 14 bytes of BMP header
+  buf[0] = 'B';
+  buf[1] = 'M';
+  put32(buf + 2, CAPTURE_BMP_HEADER + width * height * 2); // Image size
+  put32(buf + 10, CAPTURE_BMP_HEADER);  // Offset to image data
+
+  // Image header
+  put32(buf + 14, 40);                  // Header size
+  put32(buf + 18, width);
+  put32(buf + 22, height);
+  put16(buf + 26, 1);                   // 1 plane
+  put16(buf + 28, 16);                  // 16 bpp
+  put32(buf + 30, 3);                   // Compression (bit fields)
+
+  // Color masks
+  put32(buf + 54, 0xF800);              // Red mask
+  put32(buf + 58, 0x07E0);              // Green mask
+  put32(buf + 62, 0x001F);              // Blue mask
+
+  return(CAPTURE_BMP_HEADER);
+}
+
+//
+// PackBits encode sprite pixels into RGB565 little endian output,
+// returning the encoded size. Sprite pixels are stored byte swapped.
+//
+size_t captureEncodeRle(uint8_t *out, const uint16_t *pixels, size_t count)
+{
+  uint8_t *p = out;
+  size_t i = 0;
+
+  while(i < count)
+  {
+    // Measure run of identical pixels
+    size_t run = 1;
+    while(i + run < count && run < 129 && pixels[i + run] == pixels[i]) run++;
+
+    if(run >= 2)
+    {
+      *p++ = 126 + run;
+      *p++ = pixels[i] >> 8;
+      *p++ = pixels[i] & 0xFF;
+      i += run;
+      continue;
+    }
+
+    // Collect literal pixels until the next run starts
+    size_t lit = 1;
+    while(i + lit < count && lit < 128 &&
+          !(i + lit + 1 < count && pixels[i + lit] == pixels[i + lit + 1])) lit++;
+
+    *p++ = lit - 1;
+    for(; lit ; lit--, i++)
+    {
+      *p++ = pixels[i] >> 8;
+      *p++ = pixels[i] & 0xFF;
+    }
+  }
+
+  return(p - out);
+}
+
+//
+// Print current screen to the serial port as a BMP image in HEX
+//
+void captureSerialHex()
+{
+  static const char hex[] = "0123456789abcdef";
+  const uint16_t *pixels = (const uint16_t *)spr.getPointer();
+  uint16_t width  = spr.width();
+  uint16_t height = spr.height();
+  char line[CAPTURE_BMP_HEADER * 2 + 3];
+  char *p;
+
+  // BMP header
+  uint8_t header[CAPTURE_BMP_HEADER];
+  captureBmpHeader(header, width, height);
+
+  p = line;
+  for(int i=0 ; i<CAPTURE_BMP_HEADER ; i++)
+  {
+    *p++ = hex[header[i] >> 4];
+    *p++ = hex[header[i] & 15];
+  }
+
+  Serial.println("");
+  Serial.write(line, p - line);
+  Serial.println("");
+
+  // Image data, bottom to top, one line per row
+  char *row = (char *)malloc(width * 4 + 2);
+  if(!row) return;
+
+  for(int y=height-1 ; y>=0 ; y--)
+  {
+    const uint16_t *src = pixels + y * width;
+
+    // Sprite pixels are stored byte swapped, printing them as
+    // 16bit numbers produces BMP (little endian) byte order
+    p = row;
+    for(int x=0 ; x<width ; x++)
+    {
+      *p++ = hex[src[x] >> 12];
+      *p++ = hex[(src[x] >> 8) & 15];
+      *p++ = hex[(src[x] >> 4) & 15];
+      *p++ = hex[src[x] & 15];
+    }
+
+    *p++ = '\r';
+    *p++ = '\n';
+    Serial.write(row, p - row);
+  }
+
+  free(row);
+}
+
+//
+// Send current screen to the serial port as a binary RLE compressed
+// image (see CaptureHeader)
+//
+void captureSerialRle()
+{
+  const uint16_t *pixels = (const uint16_t *)spr.getPointer();
+  uint16_t width  = spr.width();
+  uint16_t height = spr.height();
+
+  uint8_t *row = (uint8_t *)malloc(CAPTURE_RLE_MAX(width));
+  if(!row) return;
+
+  // First pass computes encoded data length for the header
+  CaptureHeader header = { { 'A', 'T', 'S', 'C' }, width, height, CAPTURE_RLE_FORMAT, 0 };
+  for(int y=0 ; y<height ; y++)
+    header.length += captureEncodeRle(row, pixels + y * width, width);
+
+  Serial.write((const uint8_t *)&header, sizeof(header));
+
+  // Second pass sends encoded rows
+  for(int y=0 ; y<height ; y++)
+    Serial.write(row, captureEncodeRle(row, pixels + y * width, width));
+
+  free(row);
+}
+
+//
+// Get the size of the BMP image served by captureBmpRead()
+//
+size_t captureBmpSize()
+{
+  return(CAPTURE_BMP_HEADER + spr.width() * spr.height() * 2);
+}
+
+//
+// Start a BMP image download, to be followed by posting a snapshot
+// to the main loop. Returns the download id, or 0 if another
+// download is running or there is not enough memory. Called from
+// the web server task.
+//
+uint32_t captureBmpRequest()
+{
+  uint32_t last = captureTime;
+
+  // Refuse overlapping downloads, unless the client of the running
+  // one has stopped reading
+  if(captureState==CAPTURE_PENDING) return(0);
+  if(captureState==CAPTURE_READY && millis() - last < CAPTURE_IDLE_TIME) return(0);
+
+  if(!captureSnapshot) captureSnapshot = (uint16_t *)ps_malloc(spr.width() * spr.height() * 2);
+  if(!captureSnapshot) return(0);
+
+  captureId   = captureId + 1? captureId + 1 : 1;
+  captureTime = millis();
+  captureState = CAPTURE_PENDING;
+  return(captureId);
+}
+
+//
+// End a BMP image download, when its client disconnects
+//
+void captureBmpRelease(uint32_t id)
+{
+  if(id==captureId) captureState = CAPTURE_FREE;
+}
+
+//
+// Take a snapshot of the current screen for the pending BMP image
+// download. Called from the main loop, which owns the screen buffer.
+//
+void captureBmpSnapshot()
+{
+  if(captureState!=CAPTURE_PENDING) return;
+
+  const uint16_t *pixels = (const uint16_t *)spr.getPointer();
+  size_t count = spr.width() * spr.height();
+
+  // Convert byte swapped sprite pixels to little endian RGB565
+  for(size_t i=0 ; i<count ; i++)
+    captureSnapshot[i] = (pixels[i] >> 8) | (pixels[i] << 8);
+
+  captureState = CAPTURE_READY;
+}
+
+//
+// Fill buffer with the BMP image data of the given download,
+// starting at given index. Return the number of bytes written, or
+// ask to try again until the snapshot has been taken. A download
+// that has been taken over by a newer one reads nothing.
+//
+size_t captureBmpRead(uint32_t id, uint8_t *buf, size_t maxLen, size_t index)
+{
+  uint16_t width  = spr.width();
+  uint16_t height = spr.height();
+  size_t size = captureBmpSize();
+  size_t len = 0;
+
+  if(id!=captureId) return(0);
+  if(captureState==CAPTURE_PENDING) return(RESPONSE_TRY_AGAIN);
+  if(captureState!=CAPTURE_READY || index >= size) return(0);
+  if(maxLen > size - index) maxLen = size - index;
+  captureTime = millis();
+
+  // BMP header
+  if(index < CAPTURE_BMP_HEADER)
+  {
+    uint8_t header[CAPTURE_BMP_HEADER];
+    captureBmpHeader(header, width, height);
+    len = CAPTURE_BMP_HEADER - index < maxLen? CAPTURE_BMP_HEADER - index : maxLen;
+    memcpy(buf, header + index, len);
+  }
+
+  // Image data, bottom to top
+  const uint8_t *pixels = (const uint8_t *)captureSnapshot;
+  for(index += len ; len < maxLen ; )
+  {
+    size_t offset = index - CAPTURE_BMP_HEADER;
+    size_t y = height - 1 - offset / (width * 2);
+    size_t x = offset % (width * 2);
+    size_t n = width * 2 - x < maxLen - len? width * 2 - x : maxLen - len;
+
+    memcpy(buf + len, pixels + y * width * 2 + x, n);
+    len   += n;
+    index += n;
+  }
+
+  // Done, ready for the next download
+  if(index >= size) captureState = CAPTURE_FREE;
+
+  return(len);
+}
+
+//
+// Screen mirror WebSocket event handler
+//
+static void mirrorEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+{
+  // New clients need a full frame
+  if(type == WS_EVT_CONNECT) mirrorKeyframe = true;
+}
+
+//
+// Register screen mirror WebSocket with the web server
+//
+void mirrorInit(AsyncWebServer &server)
+{
+  mirrorWs.onEvent(mirrorEvent);
+  server.addHandler(&mirrorWs);
+}
+
+//
+// Tick screen mirror time, periodically sending changed screen tiles
+// to the connected WebSocket clients. Each message starts with:
+//   uint8_t  'K' for keyframe, 'D' for delta frame
+//   uint8_t  tile size
+//   uint16_t screen width, height
+//   uint16_t number of tiles
+// followed by tiles:
+//   uint8_t  tile column, row
+//   uint16_t encoded data length
+//   tile pixels, left to right, top to bottom, RLE encoded
+//
+void mirrorTickTime()
+{
+  static uint32_t mirrorTimer = 0;
+
+  // Nothing to do when there are no clients
+  if(!mirrorWs.count()) return;
+
+  if(millis() - mirrorTimer < mirrorInterval) return;
+  mirrorTimer = millis();
+
+  mirrorWs.cleanupClients();
+
+  // Drop frame and slow down while clients are busy with the previous one
+  if(!mirrorWs.availableForWriteAll())
+  {
+    mirrorInterval = mirrorInterval * 2 < MIRROR_MAX_INTERVAL? mirrorInterval * 2 : MIRROR_MAX_INTERVAL;
+    return;
+  }
+
+  // Speed up again while clients keep up
+  mirrorInterval -= (mirrorInterval - MIRROR_MIN_INTERVAL) / 4;
+
+  const uint16_t *pixels = (const uint16_t *)spr.getPointer();
+  uint16_t width  = spr.width();
+  uint16_t height = spr.height();
+  int cols = (width + MIRROR_TILE - 1) / MIRROR_TILE;
+  int rows = (height + MIRROR_TILE - 1) / MIRROR_TILE;
+
+  // Allocate tile hashes and the worst case message buffer
+  if(!mirrorHashes) mirrorHashes = (uint32_t *)calloc(cols * rows, sizeof(uint32_t));
+  if(!mirrorBuf) mirrorBuf = (uint8_t *)ps_malloc(8 + cols * rows * (4 + CAPTURE_RLE_MAX(MIRROR_TILE * MIRROR_TILE)));
+  if(!mirrorHashes || !mirrorBuf) return;
+
+  bool keyframe = mirrorKeyframe;
+  mirrorKeyframe = false;
+
+  uint8_t *p = mirrorBuf + 8;
+  uint16_t count = 0;
+
+  for(int ty=0 ; ty<rows ; ty++)
+  {
+    for(int tx=0 ; tx<cols ; tx++)
+    {
+      uint16_t tile[MIRROR_TILE * MIRROR_TILE];
+      int x0 = tx * MIRROR_TILE;
+      int y0 = ty * MIRROR_TILE;
+      int w  = width - x0 < MIRROR_TILE? width - x0 : MIRROR_TILE;
+      int h  = height - y0 < MIRROR_TILE? height - y0 : MIRROR_TILE;
+      uint32_t hash = 2166136261u;
+
+      // Copy tile pixels, computing FNV-1a hash
+      for(int y=0 ; y<h ; y++)
+      {
+        memcpy(tile + y * w, pixels + (y0 + y) * width + x0, w * sizeof(uint16_t));
+        for(int x=0 ; x<w ; x++) hash = (hash ^ tile[y * w + x]) * 16777619u;
+      }
+
+      // Skip unchanged tiles, unless sending a keyframe
+      if(!keyframe && mirrorHashes[ty * cols + tx] == hash) continue;
+      mirrorHashes[ty * cols + tx] = hash;
+
+      size_t len = captureEncodeRle(p + 4, tile, w * h);
+      p[0] = tx;
+      p[1] = ty;
+      put16(p + 2, len);
+      p += 4 + len;
+      count++;
+    }
+  }
+
+  // Nothing changed
+  if(!count) return;
+
+  mirrorBuf[0] = keyframe? 'K' : 'D';
+  mirrorBuf[1] = MIRROR_TILE;
+  put16(mirrorBuf + 2, width);
+  put16(mirrorBuf + 4, height);
+  put16(mirrorBuf + 6, count);
+  mirrorWs.binaryAll(mirrorBuf, p - mirrorBuf);
+}
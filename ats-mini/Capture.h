@@ -0,0 +1,52 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CAPTURE_BMP_HEADER   (14 + 40 + 12) // BMP header size, with color masks
+#define CAPTURE_RLE_FORMAT   1  // PackBits rows of RGB565 little endian pixels
+
+#define CAPTURE_FREE         0    // No screenshot download
+#define CAPTURE_PENDING      1    // Waiting for the main loop to take the snapshot
+#define CAPTURE_READY        2    // Snapshot taken, being downloaded
+#define CAPTURE_IDLE_TIME    5000 // Download assumed over after no reads for (ms)
+
+#define MIRROR_TILE          16   // Screen mirror tile size (pixels)
+#define MIRROR_MIN_INTERVAL  100  // Fastest screen mirror frame interval (ms)
+#define MIRROR_MAX_INTERVAL  2000 // Slowest screen mirror frame interval (ms)
+
+// Worst case size of an RLE encoded run of pixels
+#define CAPTURE_RLE_MAX(count) ((count) * 2 + ((count) + 127) / 128)
+
+//
+// Binary screen capture header, followed by the RLE encoded rows,
+// top to bottom. Each RLE record starts with a control byte N:
+//   N < 128  : N+1 literal pixels follow
+//   N >= 128 : the following pixel is repeated N-126 times
+//
+typedef struct __attribute__((packed))
+{
+  char magic[4];          // "ATSC"
+  uint16_t width;         // Image width
+  uint16_t height;        // Image height
+  uint8_t format;         // CAPTURE_RLE_FORMAT
+  uint32_t length;        // Encoded data length
+} CaptureHeader;
+
+size_t captureBmpHeader(uint8_t *buf, uint16_t width, uint16_t height);
+size_t captureEncodeRle(uint8_t *out, const uint16_t *pixels, size_t count);
+
+void captureSerialHex();
+void captureSerialRle();
+size_t captureBmpSize();
+uint32_t captureBmpRequest();
+void captureBmpRelease(uint32_t id);
+void captureBmpSnapshot();
+size_t captureBmpRead(uint32_t id, uint8_t *buf, size_t maxLen, size_t index);
+
+class AsyncWebServer;
+void mirrorInit(AsyncWebServer &server);
+void mirrorTickTime();
+
+#endif // CAPTURE_H
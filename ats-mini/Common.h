@@ -32,6 +32,7 @@
 #define RDS_RT        0b00001000  // Radio text
 #define RDS_PT        0b00010000  // Program type
 #define RDS_RBDS      0b00100000  // Use US PTYs
+#define RDS_AF        0b01000000  // Follow alternative frequencies
 
 // Sleep modes
 #define SLEEP_LOCKED   0 // Lock the encoder
@@ -46,6 +47,19 @@
 #define AUDIO_MUTE     3            // GPIO3    Hardware L/R mute, controlled via SI4735 code (1 = Mute)
 #define PIN_AMP_EN    10            // GPIO10   Hardware Audio Amplifer enable (1 = Enable)
 
+// Tuning delays after rx.setFrequency()
+#define TUNE_DELAY_DEFAULT 30
+#define TUNE_DELAY_FM      60
+#define TUNE_DELAY_AM_SSB  80
+#define TUNE_TIMEOUT      100 // Longest wait for tuning to complete (ms)
+
+// SSB patch loading I2C clock, falling back to the safe one on errors.
+// Builds may raise it after checking load times with the d command.
+#ifndef SSB_PATCH_CLOCK
+#define SSB_PATCH_CLOCK      400000
+#endif
+#define SSB_PATCH_SAFE_CLOCK 400000
+
 // Display PINs
 #define PIN_LCD_BL    38            // GPIO38   LCD backlight (PWM brightness control)
 // All other pins are defined by the TFT_eSPI library
@@ -128,7 +142,6 @@ extern SI4735_fixed rx;
 extern TFT_eSprite spr;
 extern TFT_eSPI tft;
 
-extern bool tuning_flag;
 extern bool pushAndRotate;
 extern bool seekStop;
 extern uint8_t rssi;
@@ -180,12 +193,27 @@ bool checkStopSeeking();
 
 // Battery.c
 float batteryMonitor();
+float batteryGetVolts();
+bool batteryTickTime();
 bool drawBattery(int x, int y);
 
 // Scan.c
 void scanRun(uint16_t centerFreq, uint16_t step);
+bool scanProbe(uint16_t freq, uint32_t budget, uint8_t *rssi, uint8_t *snr);
 float scanGetRSSI(uint16_t freq);
 float scanGetSNR(uint16_t freq);
+bool memScanOn();
+bool memScanStart(int8_t dir);
+void memScanStop();
+bool memScanTickTime();
+uint32_t memScanWaitTime(uint32_t now);
+void memScanPrintStats();
+bool prioWatchOn();
+void prioWatchStart();
+void prioWatchStop();
+bool prioWatchTickTime();
+uint32_t prioWatchWaitTime(uint32_t now);
+void prioWatchPrintStats();
 
 // Station.c
 const char *getStationName();
@@ -194,7 +222,7 @@ const char *getProgramInfo();
 const char *getRdsTime();
 uint16_t getRdsPiCode();
 void clearStationInfo();
-bool checkRds();
+bool checkRds(bool show = true);
 bool identifyFrequency(uint16_t freq, bool periodic = false);
 
 // Network.cpp
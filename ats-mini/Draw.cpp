@@ -4,12 +4,22 @@
 #include "Utils.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Perf.h"
+
+#define DRAW_URGENT_TIME    33  // Minimal interval between urgent frames (~30 FPS)
+#define DRAW_LAZY_TIME     500  // Minimal interval between lazy frames (2 FPS)
+#define DRAW_REFRESH_TIME 5000  // Background refresh when nothing else redraws
+
+static uint8_t drawPending = DRAW_NONE;
+static uint32_t drawLastTime = 0;
 
 //
 // Draw preferences write indicator
 //
 void drawSaveIndicator(int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_SAVE);
+
   if(prefsAreWritten() || switchThemeEditor())
   {
     // Draw preferences write request icon
@@ -26,6 +36,8 @@ void drawSaveIndicator(int x, int y)
 //
 void drawBleIndicator(int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_BLE);
+
   int8_t status = getBleStatus();
 
   // If need to draw BLE icon...
@@ -50,6 +62,8 @@ void drawBleIndicator(int x, int y)
 //
 void drawWiFiIndicator(int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_WIFI);
+
   int8_t status = getWiFiStatus();
 
   // If need to draw WiFi icon...
@@ -72,6 +86,8 @@ void drawWiFiIndicator(int x, int y)
 //
 bool drawWiFiStatus(const char *statusLine1, const char *statusLine2, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_STATUS);
+
   if(statusLine1 || statusLine2)
   {
     // Draw two lines of network status
@@ -115,6 +131,8 @@ void drawMessage(const char *msg)
 //
 void drawBandAndMode(const char *band, const char *mode, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_BAND);
+
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.band_text, TH.bg);
   uint16_t band_width = spr.drawString(band, x, y);
@@ -131,6 +149,8 @@ void drawBandAndMode(const char *band, const char *mode, int x, int y)
 //
 void drawRadioText(int y, int ymax)
 {
+  PERF_RENDER(PERF_DRAW_RDS);
+
   const char *rt = getRadioText();
 
   // Draw potentially multi-line radio text
@@ -144,11 +164,154 @@ void drawRadioText(int y, int ymax)
     spr.drawString(getProgramInfo(), 160, y, 2);
 }
 
+#ifndef DISABLE_GLYPH_ATLAS
+
+//
+// Frequency digits are pre-rendered into per-font glyph atlases and
+// composed by copying sprite rows, instead of rasterizing RLE font
+// glyphs on every frame
+//
+#define GLYPH_CHARS "0123456789."
+
+typedef struct
+{
+  TFT_eSprite *sprite;    // Pre-rendered glyphs, side by side
+  uint8_t font;           // TFT_eSPI font number
+  bool failed;            // TRUE: could not allocate atlas
+  uint16_t fg, bg;        // Colors atlas has been rendered with
+  int16_t height;         // Glyph height
+  int16_t x[sizeof(GLYPH_CHARS)]; // Glyph offsets, plus the total width
+} GlyphAtlas;
+
+static TFT_eSprite glyphSprite7 = TFT_eSprite(&tft);
+static TFT_eSprite glyphSprite4 = TFT_eSprite(&tft);
+static GlyphAtlas glyphs7 = { &glyphSprite7, 7 };
+static GlyphAtlas glyphs4 = { &glyphSprite4, 4 };
+
+//
+// Render atlas glyphs, if not yet rendered for the current theme
+//
+static bool glyphAtlasUpdate(GlyphAtlas *atlas)
+{
+  uint16_t fg = TH.freq_text;
+  uint16_t bg = TH.bg;
+
+  if(atlas->failed) return(false);
+  if(atlas->sprite->created() && atlas->fg==fg && atlas->bg==bg) return(true);
+
+  // Compute glyph offsets
+  if(!atlas->sprite->created())
+  {
+    char text[2] = { 0, 0 };
+    int16_t x = 0;
+
+    for(int i=0 ; GLYPH_CHARS[i] ; i++)
+    {
+      text[0] = GLYPH_CHARS[i];
+      atlas->x[i] = x;
+      x += spr.textWidth(text, atlas->font);
+    }
+
+    atlas->x[sizeof(GLYPH_CHARS) - 1] = x;
+    atlas->height = spr.fontHeight(atlas->font);
+
+    // Keep atlas in the internal RAM, it is faster to copy from
+    atlas->sprite->setAttribute(PSRAM_ENABLE, false);
+    if(!atlas->sprite->createSprite(x, atlas->height))
+    {
+      atlas->failed = true;
+      return(false);
+    }
+  }
+
+  // Render glyphs with the current theme colors
+  atlas->sprite->fillSprite(bg);
+  atlas->sprite->setTextDatum(TL_DATUM);
+  atlas->sprite->setTextColor(fg, bg);
+  for(int i=0 ; GLYPH_CHARS[i] ; i++)
+  {
+    char text[2] = { GLYPH_CHARS[i], 0 };
+    atlas->sprite->drawString(text, atlas->x[i], 0, atlas->font);
+  }
+
+  atlas->fg = fg;
+  atlas->bg = bg;
+  return(true);
+}
+
+//
+// Draw text using glyph atlas, honoring ML/MR text datums.
+// Returns FALSE if the text could not be drawn this way.
+//
+static bool glyphAtlasDraw(GlyphAtlas *atlas, const char *text, int x, int y, uint8_t datum)
+{
+  const char *p;
+  int width = 0;
+
+  if(datum!=ML_DATUM && datum!=MR_DATUM) return(false);
+  if(!glyphAtlasUpdate(atlas)) return(false);
+
+  // Compute text width, checking that all glyphs are present
+  for(p=text ; *p ; p++)
+  {
+    const char *g = strchr(GLYPH_CHARS, *p);
+    if(!g) return(false);
+    width += atlas->x[g - GLYPH_CHARS + 1] - atlas->x[g - GLYPH_CHARS];
+  }
+
+  // Align text the same way drawString() does
+  if(datum==MR_DATUM) x -= width;
+  y -= atlas->height / 2;
+
+  uint16_t *dst = (uint16_t *)spr.getPointer();
+  uint16_t *src = (uint16_t *)atlas->sprite->getPointer();
+  int dstW = spr.width();
+  int srcW = atlas->sprite->width();
+  int y0 = y<0? -y : 0;
+  int y1 = y + atlas->height > spr.height()? spr.height() - y : atlas->height;
+
+  for(p=text ; *p ; p++)
+  {
+    int g  = strchr(GLYPH_CHARS, *p) - GLYPH_CHARS;
+    int gx = atlas->x[g];
+    int gw = atlas->x[g + 1] - gx;
+    int x0 = x<0? -x : 0;
+    int x1 = x + gw > dstW? dstW - x : gw;
+
+    // Copy visible glyph rows
+    for(int r=y0 ; x0<x1 && r<y1 ; r++)
+      memcpy(dst + (y + r) * dstW + x + x0, src + r * srcW + gx + x0, (x1 - x0) * sizeof(uint16_t));
+
+    x += gw;
+  }
+
+  return(true);
+}
+
+#endif // DISABLE_GLYPH_ATLAS
+
+//
+// Draw frequency digits with the current text datum. Building with
+// DISABLE_GLYPH_ATLAS always uses drawString(), to compare the two.
+//
+static void drawFrequencyText(const char *text, int x, int y, uint8_t font)
+{
+#ifndef DISABLE_GLYPH_ATLAS
+  GlyphAtlas *atlas = font==7? &glyphs7 : &glyphs4;
+
+  if(glyphAtlasDraw(atlas, text, x, y, spr.getTextDatum())) return;
+#endif
+
+  spr.drawString(text, x, y, font);
+}
+
 //
 // Draw frequency
 //
 void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
 {
+  PERF_RENDER(PERF_DRAW_FREQ);
+
   struct Line { int x, y, w; };
 
   const Line hlDigitsFM[] =
@@ -199,7 +362,9 @@ void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
     li = hl<ITEM_COUNT(hlDigitsFM)? &hlDigitsFM[hl] : 0;
 
     // FM frequency
-    spr.drawFloat(freq/100.00, 2, x, y, 7);
+    char text[32];
+    sprintf(text, "%lu.%2.2lu", freq / 100, freq % 100);
+    drawFrequencyText(text, x, y, 7);
     spr.setTextDatum(ML_DATUM);
     spr.setTextColor(TH.funit_text, TH.bg);
     spr.drawString("MHz", ux, uy);
@@ -215,17 +380,19 @@ void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
       char text[32];
       freq = freq * 1000 + currentBFO;
       sprintf(text, "%3.3lu", freq / 1000);
-      spr.drawString(text, x, y, 7);
+      drawFrequencyText(text, x, y, 7);
       spr.setTextDatum(ML_DATUM);
       sprintf(text, ".%3.3lu", freq % 1000);
-      spr.drawString(text, 4+x, 17+y, 4);
+      drawFrequencyText(text, 4+x, 17+y, 4);
     }
     else
     {
       // AM frequency
-      spr.drawNumber(freq, x, y, 7);
+      char text[32];
+      sprintf(text, "%lu", freq);
+      drawFrequencyText(text, x, y, 7);
       spr.setTextDatum(ML_DATUM);
-      spr.drawString(".000", 4+x, 17+y, 4);
+      drawFrequencyText(".000", 4+x, 17+y, 4);
     }
 
     // SSB/AM frequencies are measured in kHz
@@ -250,27 +417,75 @@ void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
 }
 
 //
-// Draw tuner scale
+// Tuner scale is rendered into an off-screen strip covering a range
+// of frequencies around the current one. Each frame blits a window of
+// the strip, the strip is only re-rendered when the window leaves it,
+// the band changes, or the theme colors change.
 //
-void drawScale(uint32_t freq)
+#ifndef DISABLE_SCALE_CACHE
+#define SCALE_TOP        132  // Top of the cached scale area (labels)
+#define SCALE_LABEL_END  148  // Bottom of the scale labels
+#define SCALE_UNITS      120  // Strip width in 10kHz units (8 pixels each)
+#define SCALE_MARGIN       4  // Units kept off strip edges for labels
+
+typedef struct
 {
-  // Scale pointer
-  spr.fillTriangle(156, 120, 160, 130, 164, 120, TH.scale_pointer);
-  spr.drawLine(160, 130, 160, 169, TH.scale_pointer);
+  int32_t first;          // First frequency in the strip (10kHz units)
+  int32_t minFreq;        // Band edges the strip was rendered with
+  int32_t maxFreq;
+  bool fm;                // TRUE: strip has FM labels
+  bool failed;            // TRUE: could not allocate strip
+  uint16_t text, line, bg;  // Colors strip was rendered with
+  uint8_t labels[SCALE_UNITS];  // Label coverage bitmap, bit per column
+} ScaleCache;
 
-  spr.setTextDatum(MC_DATUM);
-  spr.setTextColor(TH.scale_text, TH.bg);
+static TFT_eSprite scaleSprite = TFT_eSprite(&tft);
+static ScaleCache scaleCache;
+#endif // DISABLE_SCALE_CACHE
 
-  // Scale offset
-  int16_t offset = (freq % 10) / 10.0 * 8;
+//
+// Draw scale tick for the given frequency (10kHz units), with its
+// bottom at y
+//
+static void drawScaleTick(TFT_eSprite *s, int32_t freq, int16_t x, int16_t y, uint16_t color)
+{
+  if((freq % 10) == 0)
+  {
+    s->drawLine(x, y, x, y - 19, color);
+    s->drawLine(x + 1, y, x + 1, y - 19, color);
+  }
+  else if((freq % 5) == 0)
+  {
+    s->drawLine(x, y, x, y - 14, color);
+    s->drawLine(x + 1, y, x + 1, y - 14, color);
+  }
+  else
+  {
+    s->drawLine(x, y, x, y - 9, color);
+  }
+}
 
-  // Start drawing frequencies from the left
-  freq = freq / 10 - 20;
+//
+// Draw scale label for the given frequency (10kHz units), returning
+// label width
+//
+static int16_t drawScaleLabel(TFT_eSprite *s, int32_t freq, int16_t x, int16_t y)
+{
+  if(currentMode == FM)
+    return(s->drawFloat(freq / 10.0, 1, x, y, 2));
+  else if(freq >= 100)
+    return(s->drawFloat(freq / 100.0, 3, x, y, 2));
+  else
+    return(s->drawNumber(freq * 10, x, y, 2));
+}
 
-  // Get band edges
-  const Band *band = getCurrentBand();
-  uint32_t minFreq = band->minimumFreq / 10;
-  uint32_t maxFreq = band->maximumFreq / 10;
+//
+// Draw tuner scale without using the cache
+//
+static void drawScaleDirect(int32_t freq, int16_t offset, int32_t minFreq, int32_t maxFreq)
+{
+  spr.setTextDatum(MC_DATUM);
+  spr.setTextColor(TH.scale_text, TH.bg);
 
   for(int i=0 ; i<41 ; i++, freq++)
   {
@@ -280,35 +495,159 @@ void drawScale(uint32_t freq)
       uint16_t lineColor = (i==20) && (!offset || (!(freq%5) && offset==1))?
         TH.scale_pointer : TH.scale_line;
 
-      if((freq % 10) == 0)
-      {
-        spr.drawLine(x, 169, x, 150, lineColor);
-        spr.drawLine(x + 1, 169, x + 1, 150, lineColor);
-        if(currentMode == FM)
-          spr.drawFloat(freq / 10.0, 1, x, 140, 2);
-        else if(freq >= 100)
-          spr.drawFloat(freq / 100.0, 3, x, 140, 2);
-        else
-          spr.drawNumber(freq * 10, x, 140, 2);
-      }
-      else if((freq % 5) == 0 && (freq % 10) != 0)
-      {
-        spr.drawLine(x, 169, x, 155, lineColor);
-        spr.drawLine(x + 1, 169, x + 1, 155, lineColor);
-      }
-      else
-      {
-        spr.drawLine(x, 169, x, 160, lineColor);
-      }
+      drawScaleTick(&spr, freq, x, 169, lineColor);
+      if((freq % 10) == 0) drawScaleLabel(&spr, freq, x, 140);
     }
   }
 }
 
+#ifndef DISABLE_SCALE_CACHE
+//
+// Render scale strip starting with the given frequency (10kHz units)
+//
+static bool scaleCacheUpdate(int32_t first, int32_t minFreq, int32_t maxFreq)
+{
+  ScaleCache *c = &scaleCache;
+  bool fm = currentMode == FM;
+
+  if(c->failed) return(false);
+
+  if(!scaleSprite.created())
+  {
+    if(!scaleSprite.createSprite(SCALE_UNITS * 8, 170 - SCALE_TOP))
+    {
+      c->failed = true;
+      return(false);
+    }
+  }
+  else if(c->first==first && c->minFreq==minFreq && c->maxFreq==maxFreq && c->fm==fm &&
+          c->text==TH.scale_text && c->line==TH.scale_line && c->bg==TH.bg)
+  {
+    // Strip is up to date
+    return(true);
+  }
+
+  scaleSprite.fillSprite(TH.bg);
+  scaleSprite.setTextDatum(MC_DATUM);
+  scaleSprite.setTextColor(TH.scale_text, TH.bg);
+  memset(c->labels, 0, sizeof(c->labels));
+
+  int32_t freq = first;
+  for(int16_t x=0 ; x<scaleSprite.width() ; x+=8, freq++)
+  {
+    if(freq < minFreq || freq > maxFreq) continue;
+
+    drawScaleTick(&scaleSprite, freq, x, scaleSprite.height() - 1, TH.scale_line);
+
+    if((freq % 10) == 0)
+    {
+      // Remember which columns are covered by the label
+      int16_t w = drawScaleLabel(&scaleSprite, freq, x, 140 - SCALE_TOP);
+      for(int16_t l=x-w/2 ; l<x-w/2+w ; l++)
+        if(l>=0 && l<scaleSprite.width()) c->labels[l>>3] |= 1<<(l&7);
+    }
+  }
+
+  c->first   = first;
+  c->minFreq = minFreq;
+  c->maxFreq = maxFreq;
+  c->fm      = fm;
+  c->text    = TH.scale_text;
+  c->line    = TH.scale_line;
+  c->bg      = TH.bg;
+  return(true);
+}
+
+//
+// Draw tuner scale window from the cached strip, returns FALSE if the
+// strip is not available
+//
+static bool drawScaleCached(int32_t first, int16_t offset, int32_t minFreq, int32_t maxFreq)
+{
+  // Keep current strip while the window (plus label margins) fits into it
+  int32_t start = scaleCache.first;
+  if(first - SCALE_MARGIN < start || first + 41 + SCALE_MARGIN > start + SCALE_UNITS)
+    start = first - (SCALE_UNITS - 41) / 2;
+
+  if(!scaleCacheUpdate(start, minFreq, maxFreq)) return(false);
+
+  // Copy visible window of the strip
+  uint16_t *dst = (uint16_t *)spr.getPointer() + SCALE_TOP * spr.width();
+  uint16_t *src = (uint16_t *)scaleSprite.getPointer();
+  int16_t col = (first - start) * 8 + offset;
+  for(int16_t r=0 ; r<scaleSprite.height() ; r++)
+    memcpy(dst + r * spr.width(), src + r * scaleSprite.width() + col, spr.width() * sizeof(uint16_t));
+
+  // Only keep labels of the 41 ticks drawScaleDirect() draws, erase
+  // parts of the labels just outside the window
+  for(int16_t x=0 ; x<spr.width() ; x++)
+  {
+    int16_t c = col + x;
+    if(!(scaleCache.labels[c>>3] & (1<<(c&7)))) continue;
+
+    // Labels are much narrower than the 80 pixels between them,
+    // so a label column belongs to the nearest multiple of 10
+    int32_t label = (start * 8 + c + 40) / 80 * 10;
+    if(label < first || label > first + 40)
+      spr.drawFastVLine(x, SCALE_TOP, SCALE_LABEL_END - SCALE_TOP, TH.bg);
+  }
+
+  // Scale pointer, hidden behind the labels
+  spr.fillTriangle(156, 120, 160, 130, 164, 120, TH.scale_pointer);
+  if(scaleCache.labels[(col + 160)>>3] & (1<<((col + 160)&7)))
+  {
+    spr.drawLine(160, 130, 160, SCALE_TOP - 1, TH.scale_pointer);
+    spr.drawLine(160, SCALE_LABEL_END, 160, 169, TH.scale_pointer);
+  }
+  else
+  {
+    spr.drawLine(160, 130, 160, 169, TH.scale_pointer);
+  }
+
+  // Highlight the tick under the pointer
+  int32_t freq = first + 20;
+  if(freq >= minFreq && freq <= maxFreq && (!offset || (!(freq%5) && offset==1)))
+    drawScaleTick(&spr, freq, 160 - offset, 169, TH.scale_pointer);
+
+  return(true);
+}
+#endif // DISABLE_SCALE_CACHE
+
+//
+// Draw tuner scale
+//
+void drawScale(uint32_t freq)
+{
+  PERF_RENDER(PERF_DRAW_SCALE);
+
+  // Scale offset
+  int16_t offset = (freq % 10) / 10.0 * 8;
+
+  // Start drawing frequencies from the left
+  int32_t first = freq / 10 - 20;
+
+  // Get band edges
+  const Band *band = getCurrentBand();
+  int32_t minFreq = band->minimumFreq / 10;
+  int32_t maxFreq = band->maximumFreq / 10;
+
+#ifndef DISABLE_SCALE_CACHE
+  if(drawScaleCached(first, offset, minFreq, maxFreq)) return;
+#endif
+
+  // Scale pointer
+  spr.fillTriangle(156, 120, 160, 130, 164, 120, TH.scale_pointer);
+  spr.drawLine(160, 130, 160, 169, TH.scale_pointer);
+  drawScaleDirect(first, offset, minFreq, maxFreq);
+}
+
 //
 // Draw S-meter
 //
 void drawSMeter(int strength, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_SMETER);
+
   spr.drawTriangle(x + 1, y + 1, x + 11, y + 1, x + 6, y + 6, TH.smeter_icon);
   spr.drawLine(x + 6, y + 1, x + 6, y + 14, TH.smeter_icon);
 
@@ -326,6 +665,8 @@ void drawSMeter(int strength, int x, int y)
 //
 void drawStereoIndicator(int x, int y, bool stereo)
 {
+  PERF_RENDER(PERF_DRAW_STEREO);
+
   if(stereo)
   {
     // Split S-meter into two rows
@@ -339,6 +680,8 @@ void drawStereoIndicator(int x, int y, bool stereo)
 //
 void drawStationName(const char *name, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_STATION);
+
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.rds_text, TH.bg);
   spr.drawString(name, x, y, 4);
@@ -349,6 +692,8 @@ void drawStationName(const char *name, int x, int y)
 //
 void drawLongStationName(const char *name, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_STATION);
+
   int width = spr.textWidth(name, 2);
   spr.setTextColor(TH.rds_text, TH.bg);
 
@@ -374,6 +719,8 @@ void drawLongStationName(const char *name, int x, int y)
 //
 void drawScanGraphs(uint32_t freq)
 {
+  PERF_RENDER(PERF_DRAW_SCAN);
+
   // Scale offset
   int16_t offset = (freq % 10) / 10.0 * 8;
 
@@ -424,10 +771,21 @@ void drawScanGraphs(uint32_t freq)
 //
 void drawScreen(const char *statusLine1, const char *statusLine2)
 {
+  PERF_TRACE(PERF_TRACE_DRAW);
+
+  // Any pending requests are satisfied by this frame
+  drawPending  = DRAW_NONE;
+  drawLastTime = millis();
+
   if(sleepOn()) return;
 
+  PERF_RENDER(PERF_DRAW_FRAME);
+
   // Clear screen buffer
-  spr.fillSprite(TH.bg);
+  {
+    PERF_RENDER(PERF_DRAW_CLEAR);
+    spr.fillSprite(TH.bg);
+  }
 
   // About screen is a special case
   if(currentCmd==CMD_ABOUT)
@@ -446,14 +804,74 @@ void drawScreen(const char *statusLine1, const char *statusLine2)
       break;
   }
 
-#ifdef ENABLE_HOLDOFF
-  // Update if not tuning
-  if(!tuning_flag)
+#ifdef ENABLE_PERF
+  // Show render statistics, if enabled
+  perfDrawOverlay();
+#endif
+
   {
+    PERF_RENDER(PERF_DRAW_PUSH);
     spr.pushSprite(0, 0);
   }
-#else
-  // No hold off
-  spr.pushSprite(0, 0);
-#endif
+}
+
+//
+// Request screen redraw with given priority, coalescing requests
+// until drawTickTime() decides it is time for a new frame
+//
+void drawRequest(uint8_t priority)
+{
+  if(priority > drawPending) drawPending = priority;
+}
+
+//
+// Redraw screen if requested, limiting the frame rate: urgent
+// requests (tuning, user input) are drawn at up to 30 FPS, lazy
+// requests (RSSI, RDS, clock) at up to 2 FPS
+//
+bool drawTickTime()
+{
+  uint32_t elapsed = millis() - drawLastTime;
+
+  // Periodically refresh the main screen
+  // This covers the case where there is nothing else triggering a refresh
+  if(!drawPending && currentCmd==CMD_NONE && elapsed > DRAW_REFRESH_TIME)
+    drawPending = DRAW_LAZY;
+
+  switch(drawPending)
+  {
+    case DRAW_URGENT:
+      if(elapsed < DRAW_URGENT_TIME) return(false);
+      break;
+    case DRAW_LAZY:
+      if(elapsed < DRAW_LAZY_TIME) return(false);
+      break;
+    default:
+      return(false);
+  }
+
+  drawScreen();
+  return(true);
+}
+
+//
+// Get time (ms) until drawTickTime() needs to be called again
+//
+uint32_t drawWaitTime()
+{
+  uint32_t elapsed = millis() - drawLastTime;
+  uint32_t interval;
+
+  switch(drawPending)
+  {
+    case DRAW_URGENT: interval = DRAW_URGENT_TIME; break;
+    case DRAW_LAZY:   interval = DRAW_LAZY_TIME; break;
+    default:
+      // Background refresh is only done on the main screen
+      if(currentCmd!=CMD_NONE) return(UINT32_MAX);
+      interval = DRAW_REFRESH_TIME + 1;
+      break;
+  }
+
+  return(elapsed < interval? interval - elapsed : 0);
 }
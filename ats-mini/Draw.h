@@ -32,10 +32,18 @@
 #define BLE_OFFSET_X   104    // BLE x offset
 #define BLE_OFFSET_Y     0    // BLE y offset
 
+// Redraw request priorities
+#define DRAW_NONE        0    // No redraw needed
+#define DRAW_LAZY        1    // Periodic updates (RSSI, RDS, clock)
+#define DRAW_URGENT      2    // Tuning and user input
+
 void drawMessage(const char *msg);
 void drawZoomedMenu(const char *text, bool force = false);
 void drawScanGraphs(uint32_t freq);
 void drawScreen(const char *statusLine1 = 0, const char *statusLine2 = 0);
+void drawRequest(uint8_t priority);
+bool drawTickTime();
+uint32_t drawWaitTime();
 
 void drawWiFiIndicator(int x, int y);
 void drawSaveIndicator(int x, int y);
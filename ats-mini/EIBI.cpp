@@ -1,6 +1,7 @@
 #include "Common.h"
 #include "Draw.h"
 #include "EIBI.h"
+#include "Perf.h"
 
 #include <HTTPClient.h>
 #include <WiFi.h>
@@ -384,6 +385,8 @@ static bool eibiParseLine(const char *line, StationSchedule &entry)
 
 bool eibiLoadSchedule()
 {
+  PERF_TRACE(PERF_TRACE_EIBI);
+
   static const char *eibiMessage = "Loading EiBi Schedule";
   HTTPClient http;
 
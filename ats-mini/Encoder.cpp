@@ -0,0 +1,86 @@
+#include <Arduino.h>
+#include "Encoder.h"
+
+// Encoder events, written by the interrupt handler, read by the main loop
+typedef struct
+{
+  uint32_t time;
+  int8_t dir;
+} EncoderEvent;
+
+static EncoderEvent encoderRing[ENCODER_RING_SIZE];
+static volatile uint8_t encoderHead = 0;
+static volatile uint8_t encoderTail = 0;
+
+//
+// Queue a timestamped step, dropping it if the ring is full.
+// Called by the encoder interrupt handler.
+//
+ICACHE_RAM_ATTR void encoderQueue(uint32_t time, int8_t dir)
+{
+  uint8_t head = encoderHead;
+
+  if((uint8_t)(head - encoderTail) < ENCODER_RING_SIZE)
+  {
+    encoderRing[head & (ENCODER_RING_SIZE - 1)] = { time, dir };
+    __atomic_store_n(&encoderHead, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+  }
+}
+
+//
+// Consume all encoder steps queued by the interrupt handler,
+// returning their sum. Sets *fast when the encoder is spun fast,
+// based on the smoothed interval between same direction steps.
+//
+int encoderRead(bool *fast)
+{
+  static uint32_t lastTime = 0;
+  static uint8_t interval = 255;
+  static int8_t lastDir = 0;
+  uint8_t head = __atomic_load_n(&encoderHead, __ATOMIC_ACQUIRE);
+  uint8_t tail = encoderTail;
+  int count = 0;
+
+  *fast = false;
+  if(tail == head) return(0);
+
+  while(tail != head)
+  {
+    const EncoderEvent *event = &encoderRing[tail & (ENCODER_RING_SIZE - 1)];
+    uint32_t dt = event->time - lastTime;
+
+    // Direction change restarts the estimate
+    if(event->dir != lastDir)
+      interval = 255;
+    else
+      interval = (interval * 3 + (dt < 255? dt : 255)) / 4;
+
+    lastDir  = event->dir;
+    lastTime = event->time;
+    count   += event->dir;
+    tail++;
+  }
+
+  __atomic_store_n(&encoderTail, tail, __ATOMIC_RELEASE);
+
+  *fast = interval < ENCODER_FAST_TIME;
+  return(count);
+}
+
+//
+// Check if there are steps left to read
+//
+bool encoderPending()
+{
+  return(__atomic_load_n(&encoderHead, __ATOMIC_ACQUIRE) != encoderTail);
+}
+
+//
+// Get frequency offset for dir steps, where the first step
+// snaps to the step grid if the frequency is off by stepAdjust
+//
+int32_t stepOffset(int8_t dir, int32_t step, int32_t stepAdjust)
+{
+  if(!stepAdjust || !dir) return(dir * step);
+  return(dir>0? step - stepAdjust + (dir - 1) * step : -stepAdjust + (dir + 1) * step);
+}
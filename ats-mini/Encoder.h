@@ -0,0 +1,14 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stdint.h>
+
+#define ENCODER_RING_SIZE   64  // Encoder event ring size (power of 2)
+#define ENCODER_FAST_TIME   30  // Average interval between steps to tune fast (ms)
+
+void encoderQueue(uint32_t time, int8_t dir);
+int encoderRead(bool *fast);
+bool encoderPending();
+int32_t stepOffset(int8_t dir, int32_t step, int32_t stepAdjust);
+
+#endif // ENCODER_H
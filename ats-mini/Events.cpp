@@ -0,0 +1,94 @@
+#include "Common.h"
+#include "Events.h"
+
+// Queue of events waking up the main loop
+static QueueHandle_t eventQueue = 0;
+
+#if ARDUINO_USB_MODE && ARDUINO_USB_CDC_ON_BOOT
+//
+// Serial data received (USB CDC event handler)
+//
+static void eventSerialRx(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+  eventPost(EVENT_SERIAL);
+}
+#endif
+
+//
+// Encoder button pressed or released
+//
+static void IRAM_ATTR eventButton()
+{
+  eventPostFromISR(EVENT_BUTTON);
+}
+
+//
+// Create event queue and hook input events
+//
+void eventInit()
+{
+  if(!eventQueue) eventQueue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(uint8_t));
+
+#if ARDUINO_USB_MODE && ARDUINO_USB_CDC_ON_BOOT
+  Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, eventSerialRx);
+#endif
+
+  eventAttachButton();
+}
+
+//
+// Attach encoder button interrupt (also called after the pin
+// has been reconfigured for the light sleep wakeup)
+//
+void eventAttachButton()
+{
+  attachInterrupt(digitalPinToInterrupt(ENCODER_PUSH_BUTTON), eventButton, CHANGE);
+}
+
+//
+// Post event from a task, dropping it if the queue is full
+// (the main loop is going to wake up anyway)
+//
+void eventPost(uint8_t event)
+{
+  if(eventQueue) xQueueSend(eventQueue, &event, 0);
+}
+
+//
+// Post event from an interrupt handler
+//
+void IRAM_ATTR eventPostFromISR(uint8_t event)
+{
+  BaseType_t woken = pdFALSE;
+
+  if(eventQueue)
+  {
+    xQueueSendFromISR(eventQueue, &event, &woken);
+    if(woken) portYIELD_FROM_ISR();
+  }
+}
+
+//
+// Block until an event is posted or timeout (ms) expires,
+// returning a mask of all pending events
+//
+uint8_t eventWait(uint32_t timeout)
+{
+  uint8_t event, result = EVENT_NONE;
+
+  if(!eventQueue)
+  {
+    delay(timeout);
+    return(EVENT_NONE);
+  }
+
+  // Wait for the first event
+  if(xQueueReceive(eventQueue, &event, pdMS_TO_TICKS(timeout)) != pdTRUE)
+    return(EVENT_NONE);
+
+  // Collect all other pending events
+  do result |= event;
+  while(xQueueReceive(eventQueue, &event, 0) == pdTRUE);
+
+  return(result);
+}
@@ -0,0 +1,23 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+// Events waking up the main loop (bit mask)
+#define EVENT_NONE     0x00 // Timeout, time to run periodic tasks
+#define EVENT_ENCODER  0x01 // Encoder rotated
+#define EVENT_BUTTON   0x02 // Encoder button pressed or released
+#define EVENT_SERIAL   0x04 // Serial data received
+#define EVENT_WEB      0x08 // Radio state changed via web API
+
+#define EVENT_QUEUE_SIZE 16   // Maximal number of pending events
+#define EVENT_POLL_TIME  10   // Wait time while input needs polling (ms)
+#define EVENT_MAX_WAIT   100  // Longest time the main loop may sleep (ms)
+
+void eventInit();
+void eventAttachButton();
+void eventPost(uint8_t event);
+void eventPostFromISR(uint8_t event);
+uint8_t eventWait(uint32_t timeout);
+
+#endif // EVENTS_H
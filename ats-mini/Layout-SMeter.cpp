@@ -2,6 +2,7 @@
 #include "Themes.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Perf.h"
 
 static int getInterpolatedStrength(int rssi)
 {
@@ -47,6 +48,8 @@ static int getInterpolatedStrength(int rssi)
 //
 static void drawSmallScale(uint32_t freq, int y)
 {
+  PERF_RENDER(PERF_DRAW_SCALE);
+
   const Band *band = getCurrentBand();
   const uint16_t scaleStart = 51;
   const uint16_t scaleEnd = 269;
@@ -76,6 +79,8 @@ static void drawSmallScale(uint32_t freq, int y)
 //
 static void drawAltStereoIndicator(int x, int y, bool stereo = true)
 {
+  PERF_RENDER(PERF_DRAW_STEREO);
+
   if(stereo)
   {
     spr.drawCircle(x - 4, y, 7, TH.stereo_icon);
@@ -86,6 +91,8 @@ static void drawAltStereoIndicator(int x, int y, bool stereo = true)
 
 static void drawLargeSMeter(int rssi, int strength, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_SMETER);
+
   // S-Meter legend
   for(int i=x; i<=x+15*16 + 2; i+=2) spr.drawPixel(i, 28+y, TH.scale_line);
   spr.setTextDatum(TC_DATUM);
@@ -119,6 +126,8 @@ static void drawLargeSMeter(int rssi, int strength, int x, int y)
 
 static void drawLargeSNMeter(int snr, int x, int y)
 {
+  PERF_RENDER(PERF_DRAW_SNMETER);
+
   spr.setTextColor(TH.scale_text, TH.bg);
   spr.setTextDatum(BL_DATUM);
   spr.drawString("N", x - 10, 12 + y, 2);
@@ -5,6 +5,8 @@
 #include "Menu.h"
 #include "Draw.h"
 #include "EIBI.h"
+#include "Perf.h"
+#include "Signal.h"
 
 //
 // Bands Menu
@@ -190,6 +192,8 @@ const RDSMode rdsMode[] =
   { RDS_PS | RDS_PI | RDS_RT | RDS_PT | RDS_RBDS, "ALL-CT (US)" },
   { RDS_PS | RDS_PI | RDS_RT | RDS_PT | RDS_CT, "ALL (EU)" },
   { RDS_PS | RDS_PI | RDS_RT | RDS_PT | RDS_CT | RDS_RBDS, "ALL (US)" },
+  { RDS_PS | RDS_PI | RDS_RT | RDS_PT | RDS_CT | RDS_AF, "ALL+AF (EU)" },
+  { RDS_PS | RDS_PI | RDS_RT | RDS_PT | RDS_CT | RDS_RBDS | RDS_AF, "ALL+AF (US)" },
 };
 
 uint8_t getRDSMode() { return(rdsMode[rdsModeIdx].mode); }
@@ -433,6 +437,10 @@ const Bandwidth amBandwidths[] =
 };
 int getTotalAmBandwidths() { return(ITEM_COUNT(amBandwidths)); }
 
+// SSB audio bandwidths used for AM bandwidths (by chip index) when
+// the SSB patch demodulates AM in SYNC mode
+static const uint8_t syncAmBandwidths[] = { 2, 1, 0, 5, 4, 5, 0 };
+
 static const Bandwidth *bandwidths[4] =
 {
   fmBandwidths, ssbBandwidths, ssbBandwidths, amBandwidths
@@ -468,8 +476,15 @@ static void setBandwidth()
       rx.setFmBandwidth(idx);
       break;
     case AM:
-      rx.setBandwidth(idx, 1);
-      break;
+      if(!rx.isSyncAM())
+      {
+        rx.setBandwidth(idx, 1);
+        break;
+      }
+      // SYNC mode demodulates one sideband, use the SSB audio
+      // bandwidth closest to half the AM channel filter
+      idx = syncAmBandwidths[idx];
+      // fall through
     case LSB:
     case USB:
       // Set Audio
@@ -481,15 +496,20 @@ static void setBandwidth()
   }
 }
 
-// Seek mode. Pass true to toggle, false to return the current one
+// Seek mode. Pass true to switch to the next one, false to return the current one
 uint8_t seekMode(bool toggle)
 {
   static uint8_t mode = SEEK_DEFAULT;
+  bool schedule = currentMode != FM && eibiAvailable() && clockAvailable();
 
-  mode = toggle ? (mode == SEEK_DEFAULT ? SEEK_SCHEDULE : SEEK_DEFAULT) : mode;
+  if(toggle)
+  {
+    mode = mode == SEEK_DEFAULT ? SEEK_SCHEDULE : mode == SEEK_SCHEDULE ? SEEK_MEMORY : SEEK_DEFAULT;
+    if(mode == SEEK_SCHEDULE && !schedule) mode = SEEK_MEMORY;
+  }
 
   // Use normal seek on FM or if there is no schedule loaded
-  if(currentMode == FM || !eibiAvailable() || !clockAvailable())
+  if(mode == SEEK_SCHEDULE && !schedule)
     return(SEEK_DEFAULT);
 
   return(mode);
@@ -503,9 +523,10 @@ static inline int min(int x, int y) { return(x<y? x:y); }
 
 static inline int wrap_range(int v, int dir, int vMin, int vMax)
 {
-  v += dir;
-  v  = v>vMax? vMin + (v - vMax - 1) : v<vMin? vMax - (vMin - v - 1) : v;
-  return(v);
+  // Wrap around correctly even when moving more than one range at once
+  int range = vMax - vMin + 1;
+  v = (v - vMin + dir) % range;
+  return(vMin + (v<0? v + range : v));
 }
 
 static inline int clamp_range(int v, int dir, int vMin, int vMax)
@@ -542,7 +563,12 @@ static void clickSquelch(bool shortPress)
 
 static void clickSeek(bool shortPress)
 {
-  if(shortPress) seekMode(true); else currentCmd = CMD_NONE;
+  if(shortPress)
+  {
+    memScanStop();
+    seekMode(true);
+  }
+  else currentCmd = CMD_NONE;
 }
 
 static void clickScan(bool shortPress)
@@ -551,7 +577,7 @@ static void clickScan(bool shortPress)
   {
     // Clear stale parameters
     clearStationInfo();
-    rssi = snr = 0;
+    signalReset();
     drawScreen();
     drawMessage("Scanning...");
     scanRun(currentFrequency, 10);
@@ -1044,8 +1070,23 @@ bool clickHandler(uint16_t cmd, bool shortPress)
 // Selecting given band
 //
 
+// Last band switch times (us): till audio restored, till done
+static uint32_t bandAudioTime  = 0;
+static uint32_t bandSwitchTime = 0;
+
+uint32_t getBandSwitchTime(uint32_t *audioTime)
+{
+  if(audioTime) *audioTime = bandAudioTime;
+  return(bandSwitchTime);
+}
+
 void selectBand(uint8_t idx, bool drawLoadingSSB)
 {
+  PERF_TRACE(PERF_TRACE_BAND);
+  PERF_LOOP(PERF_LOOP_BAND);
+
+  uint32_t start = micros();
+
   // Silence click on some hardware versions
   // https://github.com/esp32-si4732/ats-mini/discussions/103
   tempMuteOn(true);
@@ -1054,11 +1095,9 @@ void selectBand(uint8_t idx, bool drawLoadingSSB)
   bandIdx = min(idx, LAST_ITEM(bands));
   currentMode = bands[bandIdx].bandMode;
 
-  // Load SSB patch as needed
-  if(isSSB())
-    loadSSB(getCurrentBandwidth()->idx, drawLoadingSSB);
-  else
-    unloadSSB();
+  // Load SSB patch as needed. AM keeps using it in SYNC mode once
+  // loaded, only FM goes back to the stock firmware.
+  if(isSSB()) loadSSB(getCurrentBandwidth()->idx, drawLoadingSSB);
 
   // Switch radio to the selected band
   useBand(&bands[bandIdx]);
@@ -1066,6 +1105,10 @@ void selectBand(uint8_t idx, bool drawLoadingSSB)
   // Set bandwidth for the current mode
   setBandwidth();
 
+  // Unmute the sound as soon as the audio path is set up
+  tempMuteOn(false);
+  bandAudioTime = micros() - start;
+
   // Clear current station info (RDS/CB)
   clearStationInfo();
 
@@ -1075,8 +1118,7 @@ void selectBand(uint8_t idx, bool drawLoadingSSB)
   // Set default digit position based on the current step
   resetFreqInputPos();
 
-  // Unmute the sound
-  tempMuteOn(false);
+  bandSwitchTime = micros() - start;
 }
 
 //
@@ -1213,6 +1255,11 @@ static void drawSeek(int x, int y, int sx)
     spr.drawLine(40+x+(sx/2), 66+y, 40+x+(sx/2), 66+y-7, TH.menu_param);
     spr.drawLine(40+x+(sx/2), 66+y, 40+x+(sx/2)+4, 66+y+4, TH.menu_param);
   }
+  else if(seekMode()==SEEK_MEMORY)
+  {
+    spr.setTextColor(TH.menu_param, TH.menu_bg);
+    spr.drawString(memScanOn()? "SCAN" : "MEM", 40+x+(sx/2), 66+y, 2);
+  }
 }
 
 static void drawScan(int x, int y, int sx)
@@ -1700,6 +1747,8 @@ static void drawInfo(int x, int y, int sx)
 //
 void drawSideBar(uint16_t cmd, int x, int y, int sx)
 {
+  PERF_RENDER(PERF_DRAW_SIDEBAR);
+
   if(sleepOn()) return;
 
   switch(cmd)
@@ -52,6 +52,7 @@
 // Seek modes
 #define SEEK_DEFAULT  0
 #define SEEK_SCHEDULE 1
+#define SEEK_MEMORY   2
 
 //
 // Data Types
@@ -82,6 +83,7 @@ typedef struct
 
 extern Band bands[];
 extern Memory memories[];
+extern uint8_t memoryIdx;
 extern const char *sleepModeDesc[];
 extern const UTCOffset utcOffsets[];
 extern const char *uiLayoutDesc[];
@@ -114,6 +116,7 @@ bool doSideBar(uint16_t cmd, int dir);
 void doSelectDigit(int dir);
 bool clickHandler(uint16_t cmd, bool shortPress);
 void selectBand(uint8_t idx, bool drawLoadingSSB = true);
+uint32_t getBandSwitchTime(uint32_t *audioTime = 0);
 int getTotalBands();
 int getTotalModes();
 int getTotalMemories();
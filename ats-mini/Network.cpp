@@ -3,8 +3,12 @@
 #include "Themes.h"
 #include "Utils.h"
 #include "Draw.h"
+#include "Button.h"
 #include "WebApi.h"
 #include "WebUi.h"
+#include "Capture.h"
+#include "RdsLog.h"
+#include "Perf.h"
 
 #include <WiFi.h>
 #include <WiFiUdp.h>
@@ -118,6 +122,8 @@ void netStop()
 //
 void netInit(uint8_t netMode, bool showStatus)
 {
+  PERF_TRACE(PERF_TRACE_NETINIT);
+
   // Always disable WiFi first
   netStop();
 
@@ -190,6 +196,8 @@ bool ntpIsAvailable()
 //
 bool ntpSyncTime()
 {
+  PERF_TRACE(PERF_TRACE_NTP);
+
   if(WiFi.status()==WL_CONNECTED)
   {
     ntpClient.update();
@@ -232,6 +240,8 @@ static bool wifiInitAP()
 //
 static bool wifiConnect()
 {
+  PERF_TRACE(PERF_TRACE_WIFI);
+
   String status = "Connecting to WiFi network..";
 
   // Get the preferences
@@ -260,7 +270,7 @@ static bool wifiConnect()
           drawScreen(status.c_str());
         }
         delay(500);
-        if(digitalRead(ENCODER_PUSH_BUTTON)==LOW)
+        if(buttonPressed())
         {
           WiFi.disconnect();
           break;
@@ -300,6 +310,8 @@ static void webInit()
 {
   addApiListeners(server);
   addUiListeners(server);
+  mirrorInit(server);
+  rdsLogInit(server);
 
   server.onNotFound([] (AsyncWebServerRequest *request) {
     request->send(404, "text/plain", "Not found");
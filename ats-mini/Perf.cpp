@@ -0,0 +1,340 @@
+#include "Common.h"
+#include "Themes.h"
+#include "Perf.h"
+
+#ifdef ENABLE_PERF
+
+typedef struct
+{
+  uint32_t count;                 // Total number of samples
+  uint32_t samples[PERF_SAMPLES]; // Most recent samples (CPU cycles)
+} PerfProbe;
+
+static const char *perfRenderNames[PERF_DRAW_COUNT] =
+{
+  "frame", "clear", "save", "ble", "battery", "wifi", "band", "frequency",
+  "station", "sidebar", "smeter", "snmeter", "stereo", "scale", "scan",
+  "status", "rds", "push"
+};
+
+static const char *perfLoopNames[PERF_LOOP_COUNT] =
+{
+  "loop", "button", "remote", "ble", "rssi", "rds", "schedule", "ntp",
+  "prefs", "net", "draw", "idle", "seek", "scan", "band"
+};
+
+static const char *perfTraceNames[PERF_TRACE_COUNT] =
+{
+  "loop", "drawScreen", "signalSample", "checkRds", "identifyFrequency",
+  "prefsTickTime", "selectBand", "doSeek", "sleepOn", "netInit",
+  "wifiConnect", "ntpSyncTime", "eibiLoadSchedule", "remoteDoCommand",
+  "radioTickTime"
+};
+
+static const char *perfI2cNames[PERF_I2C_COUNT] =
+{
+  "other", "tune", "rssi", "rds", "band", "patch"
+};
+
+// Trace ring, written by the main loop only
+static PerfTraceEvent perfTrace[PERF_TRACE_SIZE];
+static uint32_t perfTraceCount = 0;
+static uint32_t perfTraceLoopStart = 0;
+
+// Trace frozen after the most recent long loop iteration
+static PerfTraceEvent perfTraceFrozen[PERF_TRACE_SIZE];
+static size_t perfTraceFrozenCount = 0;
+static uint32_t perfTraceFrozenTime = 0;
+static portMUX_TYPE perfTraceMux = portMUX_INITIALIZER_UNLOCKED;
+
+// I2C transactions, issued by the main loop only
+static PerfI2cStats perfI2c[PERF_I2C_COUNT];
+static PerfI2cEvent perfI2cRing[PERF_I2C_SIZE];
+static uint32_t perfI2cRingCount = 0;
+static uint8_t perfI2cCurrent = PERF_I2C_OTHER;
+static portMUX_TYPE perfI2cMux = portMUX_INITIALIZER_UNLOCKED;
+
+static PerfProbe perfRender[PERF_DRAW_COUNT];
+static PerfHistogram perfLoop[PERF_LOOP_COUNT];
+static uint32_t perfLoopStart = 0;    // Last mark or lap (us)
+static bool perfOverlay = false;
+
+//
+// Add a new sample to the probe ring
+//
+static void perfProbeAdd(PerfProbe *probe, uint32_t cycles)
+{
+  probe->samples[probe->count++ % PERF_SAMPLES] = cycles;
+}
+
+//
+// Compute statistics over the recent probe samples
+//
+static bool perfProbeStats(const PerfProbe *probe, PerfStats *stats)
+{
+  // On the stack, this runs on both the main loop and web server tasks
+  uint32_t sorted[PERF_SAMPLES];
+  uint32_t n = probe->count < PERF_SAMPLES? probe->count : PERF_SAMPLES;
+  uint64_t total = 0;
+
+  if(!n) return(false);
+
+  // Insertion sort, the number of samples is small
+  for(uint32_t i=0 ; i<n ; i++)
+  {
+    uint32_t v = probe->samples[i];
+    uint32_t j;
+
+    for(j=i ; j>0 && sorted[j-1]>v ; j--) sorted[j] = sorted[j-1];
+    sorted[j] = v;
+    total += v;
+  }
+
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  stats->count = probe->count;
+  stats->min   = sorted[0] / mhz;
+  stats->avg   = total / n / mhz;
+  stats->p99   = sorted[(n * 99 + 99) / 100 - 1] / mhz;
+  return(true);
+}
+
+void perfRenderAdd(uint8_t id, uint32_t cycles)
+{
+  if(id<PERF_DRAW_COUNT) perfProbeAdd(&perfRender[id], cycles);
+}
+
+bool perfRenderStats(uint8_t id, PerfStats *stats)
+{
+  return(id<PERF_DRAW_COUNT && perfProbeStats(&perfRender[id], stats));
+}
+
+const char *perfRenderName(uint8_t id)
+{
+  return(id<PERF_DRAW_COUNT? perfRenderNames[id] : "");
+}
+
+//
+// Add a main loop phase sample to its histogram
+//
+void perfLoopAdd(uint8_t id, uint32_t us)
+{
+  if(id>=PERF_LOOP_COUNT) return;
+
+  PerfHistogram *h = &perfLoop[id];
+  uint8_t bucket = us? 32 - __builtin_clz(us) : 0;
+
+  h->count++;
+  h->total += us;
+  h->max = us > h->max? us : h->max;
+  h->buckets[bucket < PERF_BUCKETS? bucket : PERF_BUCKETS - 1]++;
+}
+
+void perfLoopMark()
+{
+  perfLoopStart = micros();
+}
+
+void perfLoopLap(uint8_t id)
+{
+  uint32_t now = micros();
+  perfLoopAdd(id, now - perfLoopStart);
+  perfLoopStart = now;
+}
+
+const PerfHistogram *perfLoopHistogram(uint8_t id)
+{
+  return(id<PERF_LOOP_COUNT? &perfLoop[id] : 0);
+}
+
+const char *perfLoopName(uint8_t id)
+{
+  return(id<PERF_LOOP_COUNT? perfLoopNames[id] : "");
+}
+
+//
+// Print main loop phase histograms and render statistics to serial
+//
+void perfPrint()
+{
+  Serial.println("Loop phase: count avg max (us), histogram (<1us, <2us, <4us, ...)");
+
+  for(uint8_t id=0 ; id<PERF_LOOP_COUNT ; id++)
+  {
+    const PerfHistogram *h = &perfLoop[id];
+    if(!h->count) continue;
+
+    Serial.printf("%-9s %8lu %8lu %8lu :", perfLoopNames[id], h->count, (uint32_t)(h->total / h->count), h->max);
+    for(uint8_t j=0 ; j<PERF_BUCKETS ; j++) Serial.printf(" %lu", h->buckets[j]);
+    Serial.println();
+  }
+
+  Serial.println("I2C operation: count bytes avg cts max (us)");
+
+  for(uint8_t op=0 ; op<PERF_I2C_COUNT ; op++)
+  {
+    const PerfI2cStats *st = &perfI2c[op];
+    if(!st->count) continue;
+
+    Serial.printf("%-9s %8lu %8lu %8lu %8lu %8lu\r\n", perfI2cNames[op], st->count, st->bytes,
+      (uint32_t)(st->total / st->count), (uint32_t)(st->cts / st->count), st->max
+    );
+  }
+
+  Serial.println("Render probe: count min avg p99 (us)");
+
+  for(uint8_t id=0 ; id<PERF_DRAW_COUNT ; id++)
+  {
+    PerfStats stats;
+    if(!perfRenderStats(id, &stats)) continue;
+    Serial.printf("%-9s %8lu %8lu %8lu %8lu\r\n", perfRenderNames[id], stats.count, stats.min, stats.avg, stats.p99);
+  }
+}
+
+//
+// Add trace event, freezing the trace if the current main
+// loop iteration took too long
+//
+void perfTraceAdd(uint8_t id, char phase)
+{
+  uint32_t now = micros();
+
+  perfTrace[perfTraceCount++ % PERF_TRACE_SIZE] = { now, id, phase };
+
+  if(id != PERF_TRACE_LOOP) return;
+  if(phase == 'B')
+  {
+    perfTraceLoopStart = now;
+    return;
+  }
+
+  // Freeze the trace on the most recent stall
+  uint32_t duration = now - perfTraceLoopStart;
+  if(duration < PERF_TRACE_STALL * 1000) return;
+
+  // Copy trace events in chronological order
+  size_t n = perfTraceCount < PERF_TRACE_SIZE? perfTraceCount : PERF_TRACE_SIZE;
+  size_t first = perfTraceCount - n;
+
+  taskENTER_CRITICAL(&perfTraceMux);
+  for(size_t i=0 ; i<n ; i++)
+    perfTraceFrozen[i] = perfTrace[(first + i) % PERF_TRACE_SIZE];
+  perfTraceFrozenCount = n;
+  perfTraceFrozenTime  = duration;
+  taskEXIT_CRITICAL(&perfTraceMux);
+}
+
+const char *perfTraceName(uint8_t id)
+{
+  return(id<PERF_TRACE_COUNT? perfTraceNames[id] : "");
+}
+
+//
+// Copy frozen trace into events (PERF_TRACE_SIZE entries), returning
+// the number of events and the stalled iteration duration (us)
+//
+size_t perfTraceSnapshot(PerfTraceEvent *events, uint32_t *duration)
+{
+  taskENTER_CRITICAL(&perfTraceMux);
+  size_t n = perfTraceFrozenCount;
+  memcpy(events, perfTraceFrozen, n * sizeof(PerfTraceEvent));
+  *duration = perfTraceFrozenTime;
+  taskEXIT_CRITICAL(&perfTraceMux);
+
+  return(n);
+}
+
+//
+// Add I2C transaction to the current operation statistics
+// and to the ring of recent transactions
+//
+void perfI2cAdd(uint8_t opcode, uint16_t bytes, uint32_t start, uint32_t cts, uint32_t end)
+{
+  PerfI2cStats *st = &perfI2c[perfI2cCurrent];
+  uint32_t duration = end - start;
+
+  // Statistics and ring are read by the web server task
+  taskENTER_CRITICAL(&perfI2cMux);
+  st->count++;
+  st->bytes += bytes;
+  st->total += duration;
+  st->cts   += cts - start;
+  st->max    = duration > st->max? duration : st->max;
+  perfI2cRing[perfI2cRingCount++ % PERF_I2C_SIZE] =
+    { start, duration, cts - start, bytes, opcode, perfI2cCurrent };
+  taskEXIT_CRITICAL(&perfI2cMux);
+}
+
+//
+// Set current operation, returning the previous one
+//
+uint8_t perfI2cOp(uint8_t op)
+{
+  uint8_t prev = perfI2cCurrent;
+  perfI2cCurrent = op<PERF_I2C_COUNT? op : PERF_I2C_OTHER;
+  return(prev);
+}
+
+bool perfI2cStats(uint8_t op, PerfI2cStats *stats)
+{
+  if(op>=PERF_I2C_COUNT) return(false);
+
+  taskENTER_CRITICAL(&perfI2cMux);
+  *stats = perfI2c[op];
+  taskEXIT_CRITICAL(&perfI2cMux);
+  return(true);
+}
+
+const char *perfI2cName(uint8_t op)
+{
+  return(op<PERF_I2C_COUNT? perfI2cNames[op] : "");
+}
+
+//
+// Copy recent I2C transactions into events (PERF_I2C_SIZE entries)
+// in chronological order, returning the number of transactions
+//
+size_t perfI2cSnapshot(PerfI2cEvent *events)
+{
+  taskENTER_CRITICAL(&perfI2cMux);
+  size_t n = perfI2cRingCount < PERF_I2C_SIZE? perfI2cRingCount : PERF_I2C_SIZE;
+  size_t first = perfI2cRingCount - n;
+  for(size_t i=0 ; i<n ; i++)
+    events[i] = perfI2cRing[(first + i) % PERF_I2C_SIZE];
+  taskEXIT_CRITICAL(&perfI2cMux);
+
+  return(n);
+}
+
+//
+// Set, reset, or query render statistics overlay
+//
+bool perfOverlayOn(int x)
+{
+  perfOverlay = x==0? false : x==1? true : perfOverlay;
+  return(perfOverlay);
+}
+
+//
+// Draw render statistics (avg/p99, in microseconds) over the screen
+//
+void perfDrawOverlay()
+{
+  if(!perfOverlay) return;
+
+  spr.fillRect(200, 16, 120, PERF_DRAW_COUNT * 8 + 4, TH.bg);
+  spr.drawRect(200, 16, 120, PERF_DRAW_COUNT * 8 + 4, TH.text_warn);
+  spr.setTextDatum(TL_DATUM);
+  spr.setTextColor(TH.text_warn, TH.bg);
+
+  for(uint8_t id=0 ; id<PERF_DRAW_COUNT ; id++)
+  {
+    PerfStats stats;
+    char text[32];
+
+    if(!perfRenderStats(id, &stats)) continue;
+    sprintf(text, "%-9s%5lu%6lu", perfRenderName(id), stats.avg, stats.p99);
+    spr.drawString(text, 203, 18 + id * 8, 1);
+  }
+}
+
+#endif // ENABLE_PERF
@@ -0,0 +1,251 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <Arduino.h>
+
+// Render probes
+#define PERF_DRAW_FRAME     0   // Whole drawScreen()
+#define PERF_DRAW_CLEAR     1   // Clearing screen buffer
+#define PERF_DRAW_SAVE      2
+#define PERF_DRAW_BLE       3
+#define PERF_DRAW_BATTERY   4
+#define PERF_DRAW_WIFI      5
+#define PERF_DRAW_BAND      6
+#define PERF_DRAW_FREQ      7
+#define PERF_DRAW_STATION   8
+#define PERF_DRAW_SIDEBAR   9
+#define PERF_DRAW_SMETER   10
+#define PERF_DRAW_SNMETER  11
+#define PERF_DRAW_STEREO   12
+#define PERF_DRAW_SCALE    13
+#define PERF_DRAW_SCAN     14
+#define PERF_DRAW_STATUS   15
+#define PERF_DRAW_RDS      16
+#define PERF_DRAW_PUSH     17   // Sending screen buffer to the display
+#define PERF_DRAW_COUNT    18
+
+// Main loop phase probes
+#define PERF_LOOP_ITERATION 0   // Whole loop() iteration, including idle time
+#define PERF_LOOP_BUTTON    1
+#define PERF_LOOP_REMOTE    2
+#define PERF_LOOP_BLE       3
+#define PERF_LOOP_RSSI      4
+#define PERF_LOOP_RDS       5
+#define PERF_LOOP_SCHEDULE  6
+#define PERF_LOOP_NTP       7
+#define PERF_LOOP_PREFS     8
+#define PERF_LOOP_NET       9
+#define PERF_LOOP_DRAW     10   // Drawing a frame, if any
+#define PERF_LOOP_IDLE     11   // Waiting for events
+#define PERF_LOOP_SEEK     12   // Whole seek, time to complete
+#define PERF_LOOP_SCAN     13   // Whole band scan, time to complete
+#define PERF_LOOP_BAND     14   // Whole band switch, time to complete
+#define PERF_LOOP_COUNT    15
+
+// Traced functions
+#define PERF_TRACE_LOOP     0   // Main loop iteration, excluding idle time
+#define PERF_TRACE_DRAW     1
+#define PERF_TRACE_RSSI     2
+#define PERF_TRACE_RDS      3
+#define PERF_TRACE_SCHEDULE 4
+#define PERF_TRACE_PREFS    5
+#define PERF_TRACE_BAND     6
+#define PERF_TRACE_SEEK     7
+#define PERF_TRACE_SLEEP    8
+#define PERF_TRACE_NETINIT  9
+#define PERF_TRACE_WIFI    10
+#define PERF_TRACE_NTP     11
+#define PERF_TRACE_EIBI    12
+#define PERF_TRACE_REMOTE  13
+#define PERF_TRACE_WEB     14   // Executing web radio commands
+#define PERF_TRACE_COUNT   15
+
+// Operations issuing I2C transactions to the radio chip
+#define PERF_I2C_OTHER      0
+#define PERF_I2C_TUNE       1   // Tuning steps
+#define PERF_I2C_RSSI       2   // RSSI/SNR polling
+#define PERF_I2C_RDS        3   // RDS polling
+#define PERF_I2C_BAND       4   // Band switches
+#define PERF_I2C_PATCH      5   // SSB patch loading
+#define PERF_I2C_COUNT      6
+
+#define PERF_I2C_SIZE      64   // I2C transactions kept
+
+#define PERF_TRACE_SIZE   256   // Trace events kept
+#define PERF_TRACE_STALL  200   // Loop iteration time that freezes the trace (ms)
+
+#define PERF_SAMPLES      128   // Samples kept per probe
+#define PERF_BUCKETS       24   // Histogram buckets: <1us, <2us, <4us, ... >=4.2s
+
+typedef struct
+{
+  uint32_t count;         // Total number of samples taken
+  uint32_t min;           // Minimum of the recent samples (us)
+  uint32_t avg;           // Average of the recent samples (us)
+  uint32_t p99;           // 99th percentile of the recent samples (us)
+} PerfStats;
+
+typedef struct
+{
+  uint32_t count;                 // Total number of samples
+  uint32_t max;                   // Longest sample (us)
+  uint64_t total;                 // Sum of all samples (us)
+  uint32_t buckets[PERF_BUCKETS]; // Sample counts by power of 2 duration (us)
+} PerfHistogram;
+
+typedef struct
+{
+  uint32_t time;          // Event time (us)
+  uint8_t id;             // PERF_TRACE_*
+  char phase;             // 'B' for begin, 'E' for end
+} PerfTraceEvent;
+
+typedef struct
+{
+  uint32_t count;         // Number of transactions
+  uint32_t bytes;         // Bytes written and read
+  uint32_t max;           // Longest transaction (us)
+  uint64_t total;         // Sum of transaction times (us)
+  uint64_t cts;           // Sum of times spent waiting for CTS (us)
+} PerfI2cStats;
+
+typedef struct
+{
+  uint32_t time;          // Transaction start (us)
+  uint32_t duration;      // Transaction time, including CTS wait (us)
+  uint32_t cts;           // Time spent waiting for CTS (us)
+  uint16_t bytes;         // Bytes written and read
+  uint8_t opcode;         // SI4735 command
+  uint8_t op;             // PERF_I2C_*
+} PerfI2cEvent;
+
+#ifdef ENABLE_PERF
+
+void perfRenderAdd(uint8_t id, uint32_t cycles);
+bool perfRenderStats(uint8_t id, PerfStats *stats);
+const char *perfRenderName(uint8_t id);
+bool perfOverlayOn(int x = 2);
+void perfDrawOverlay();
+
+void perfLoopAdd(uint8_t id, uint32_t us);
+void perfLoopMark();
+void perfLoopLap(uint8_t id);
+const PerfHistogram *perfLoopHistogram(uint8_t id);
+const char *perfLoopName(uint8_t id);
+void perfPrint();
+
+void perfTraceAdd(uint8_t id, char phase);
+const char *perfTraceName(uint8_t id);
+size_t perfTraceSnapshot(PerfTraceEvent *events, uint32_t *duration);
+
+void perfI2cAdd(uint8_t opcode, uint16_t bytes, uint32_t start, uint32_t cts, uint32_t end);
+uint8_t perfI2cOp(uint8_t op);
+bool perfI2cStats(uint8_t op, PerfI2cStats *stats);
+const char *perfI2cName(uint8_t op);
+size_t perfI2cSnapshot(PerfI2cEvent *events);
+
+//
+// Times an I2C transaction, from its construction till destruction
+//
+class PerfI2cProbe
+{
+  public:
+    PerfI2cProbe(uint8_t opcode, uint16_t bytes) : opcode(opcode), bytes(bytes), start(micros()), ready(start) {}
+    ~PerfI2cProbe() { perfI2cAdd(opcode, bytes, start, ready, micros()); }
+    void clearToSend() { ready = micros(); }
+
+  private:
+    uint8_t opcode;
+    uint16_t bytes;
+    uint32_t start;
+    uint32_t ready;
+};
+
+//
+// Accounts I2C transactions in its scope to an operation
+//
+class PerfI2cScope
+{
+  public:
+    PerfI2cScope(uint8_t op) : prev(perfI2cOp(op)) {}
+    ~PerfI2cScope() { perfI2cOp(prev); }
+
+  private:
+    uint8_t prev;
+};
+
+//
+// Measures CPU cycles spent between its construction and destruction
+//
+class PerfRenderProbe
+{
+  public:
+    PerfRenderProbe(uint8_t id) : id(id), start(ESP.getCycleCount()) {}
+    ~PerfRenderProbe() { perfRenderAdd(id, ESP.getCycleCount() - start); }
+
+  private:
+    uint8_t id;
+    uint32_t start;
+};
+
+//
+// Measures time spent in a main loop phase or a long operation. Uses
+// microseconds, the 32-bit cycle counter wraps every 53s at 80MHz.
+//
+class PerfLoopProbe
+{
+  public:
+    PerfLoopProbe(uint8_t id) : id(id), start(micros()) {}
+    ~PerfLoopProbe() { perfLoopAdd(id, micros() - start); }
+
+  private:
+    uint8_t id;
+    uint32_t start;
+};
+
+//
+// Traces begin and end of its scope
+//
+class PerfTraceScope
+{
+  public:
+    PerfTraceScope(uint8_t id) : id(id) { perfTraceAdd(id, 'B'); }
+    ~PerfTraceScope() { perfTraceAdd(id, 'E'); }
+
+  private:
+    uint8_t id;
+};
+
+// Trace the rest of the current scope, or explicit begin and end
+#define PERF_TRACE(id)       PerfTraceScope perfTraceScope(id)
+#define PERF_TRACE_BEGIN(id) perfTraceAdd(id, 'B')
+#define PERF_TRACE_END(id)   perfTraceAdd(id, 'E')
+
+// Time the rest of the current scope as an I2C transaction, first
+// waiting for CTS, or account I2C transactions to an operation
+#define PERF_I2C(opcode, bytes, wait) PerfI2cProbe perfI2cProbe(opcode, bytes); wait; perfI2cProbe.clearToSend()
+#define PERF_I2C_OP(op) PerfI2cScope perfI2cScope(op)
+
+// Measure the rest of the current scope
+#define PERF_RENDER(id) PerfRenderProbe perfRenderProbe(id)
+#define PERF_LOOP(id)   PerfLoopProbe perfLoopProbe(id)
+
+// Measure a main loop phase, from the last mark or lap till this lap
+#define PERF_LOOP_MARK()    perfLoopMark()
+#define PERF_LOOP_LAP(id)   perfLoopLap(id)
+
+#else
+
+#define PERF_TRACE(id)
+#define PERF_TRACE_BEGIN(id) do {} while(0)
+#define PERF_TRACE_END(id)   do {} while(0)
+#define PERF_I2C(opcode, bytes, wait)
+#define PERF_I2C_OP(op)
+#define PERF_RENDER(id)
+#define PERF_LOOP(id)
+#define PERF_LOOP_MARK()    do {} while(0)
+#define PERF_LOOP_LAP(id)   do {} while(0)
+
+#endif // ENABLE_PERF
+
+#endif // PERF_H
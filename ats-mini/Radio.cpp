@@ -0,0 +1,306 @@
+#include "Common.h"
+#include "Radio.h"
+#include "Menu.h"
+#include "Storage.h"
+#include "Utils.h"
+#include "Events.h"
+#include "Perf.h"
+#include "Signal.h"
+#include "Themes.h"
+#include "Capture.h"
+
+// Commands from other tasks, executed by the main loop, which
+// remains the only owner of the radio and its I2C bus. Requests
+// are numbered, their completion is published with the status.
+static QueueHandle_t radioQueue = 0;
+static uint32_t radioRequestId = 0;
+static uint32_t radioDoneId = 0;
+static uint32_t radioFailedId = 0;
+static bool radioOk = true;
+
+// Double buffered radio status, written by the main loop only
+static RadioStatus radioStatus[2];
+static volatile uint32_t radioStatusSeq = 0;
+
+static void radioPublish();
+
+static inline int clamp_range(int v, int vMin, int vMax)
+{
+  return(v<vMin? vMin : v>vMax? vMax : v);
+}
+
+//
+// Create command queue
+//
+void radioInit()
+{
+  if(!radioQueue) radioQueue = xQueueCreate(RADIO_QUEUE_SIZE, sizeof(RadioCommand));
+  radioPublish();
+}
+
+//
+// Add command to a request
+//
+void radioAdd(RadioBatch *batch, uint8_t cmd, int32_t a, int32_t b)
+{
+  if(batch->count < RADIO_BATCH_SIZE)
+    batch->commands[batch->count++] = { cmd, a, b };
+}
+
+//
+// Post all commands of a request to the main loop, waking it up,
+// without waiting for them to execute. Returns the request id,
+// reported by radioGetStatus() once done, or 0 if the queue has
+// no room for the whole request. Only one task (web server) is
+// expected to post.
+//
+uint32_t radioPost(const RadioBatch *batch)
+{
+  if(!radioQueue || uxQueueSpacesAvailable(radioQueue) < batch->count + 1u)
+    return(0);
+
+  // Request ids are never 0
+  uint32_t id = ++radioRequestId? radioRequestId : ++radioRequestId;
+  RadioCommand done = { RADIO_CMD_DONE, (int32_t)id, RADIO_UNSET };
+
+  for(uint8_t i=0 ; i<batch->count ; i++)
+    xQueueSend(radioQueue, &batch->commands[i], 0);
+  xQueueSend(radioQueue, &done, 0);
+
+  eventPost(EVENT_WEB);
+  return(id);
+}
+
+//
+// Set AGC and/or attenuation
+//
+static void radioSetAgc(int32_t agc, int32_t attenuation)
+{
+  int8_t maxAttenuation = currentMode==FM? 26 : isSSB()? 0 : 36;
+
+  // Enabling AGC ignores attenuation
+  if(agc!=RADIO_UNSET && agc && attenuation!=RADIO_UNSET) return;
+
+  if(attenuation!=RADIO_UNSET)
+    switchAgc(clamp_range(attenuation, 0, maxAttenuation) + 1);
+  else
+    switchAgc(agc? 0 : 1);
+
+  prefsRequestSave(SAVE_SETTINGS, true);
+}
+
+//
+// Execute a single command, returning false if it has failed
+//
+static bool radioExecute(const RadioCommand *command)
+{
+  PERF_TRACE(PERF_TRACE_WEB);
+
+  switch(command->cmd)
+  {
+    case RADIO_CMD_BAND:
+      switchBand(clamp_range(command->a, 0, getTotalBands() - 1));
+      prefsRequestSave(SAVE_SETTINGS | SAVE_BANDS, true);
+      break;
+
+    case RADIO_CMD_FREQ:
+      updateFrequency(freqFromHz(command->a, currentMode), true);
+      if(isSSB()) updateBFO(bfoFromHz(command->a), true);
+
+      // Clear current station name and information
+      clearStationInfo();
+      // Check for named frequencies
+      identifyFrequency(currentFrequency + currentBFO / 1000);
+
+      prefsRequestSave(SAVE_SETTINGS | SAVE_CUR_BAND, true);
+      break;
+
+    case RADIO_CMD_STEP:
+      switchStep(clamp_range(command->a, 0, getLastStep(currentMode)));
+      prefsRequestSave(SAVE_CUR_BAND, true);
+      break;
+
+    case RADIO_CMD_BANDWIDTH:
+      switchBandwidth(clamp_range(command->a, 0, getLastBandwidth(currentMode)));
+      prefsRequestSave(SAVE_CUR_BAND, true);
+      break;
+
+    case RADIO_CMD_AGC:
+      radioSetAgc(command->a, command->b);
+      break;
+
+    case RADIO_CMD_VOLUME:
+      volume = clamp_range(command->a, 0, 63);
+      if(!muteOn()) rx.setVolume(volume);
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_SQUELCH:
+      currentSquelch = clamp_range(command->a, 0, 127);
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_SOFTMUTE:
+      if(currentMode==FM) break;
+      switchSoftMute(clamp_range(command->a, 0, 32));
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_AVC:
+      if(currentMode==FM) break;
+      switchAvc(clamp_range(command->a, 12, 90));
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_MEMORY:
+      if(command->a<0 || command->a>=MEMORY_COUNT) return(false);
+      return(tuneToMemory(&memories[command->a]));
+
+    case RADIO_CMD_CAL:
+      getCurrentBand()->bandCal = command->a;
+      if(isSSB()) updateBFO(currentBFO, true);
+      prefsRequestSave(SAVE_CUR_BAND | SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_FMREGION:
+      FmRegionIdx = command->a;
+      rx.setFMDeEmphasis(fmRegions[FmRegionIdx].value);
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_BRIGHTNESS:
+      currentBrt = command->a;
+      if(!sleepOn()) ledcWrite(PIN_LCD_BL, currentBrt);
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_RDSMODE:
+      rdsModeIdx = command->a;
+      if(!(getRDSMode() & RDS_CT)) clockReset();
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_UTCOFFSET:
+      utcOffsetIdx = command->a;
+      clockRefreshTime();
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_THEME:
+      themeIdx = command->a;
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_UILAYOUT:
+      uiLayoutIdx = command->a;
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_ZOOMMENU:
+      zoomMenu = command->a;
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_SCROLLDIR:
+      if(command->a!=-1 && command->a!=1) return(false);
+      scrollDirection = command->a;
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_SLEEPMODE:
+      sleepModeIdx = command->a;
+      prefsRequestSave(SAVE_SETTINGS, true);
+      break;
+
+    case RADIO_CMD_SCREENSHOT:
+      captureBmpSnapshot();
+      break;
+
+    default:
+      return(false);
+  }
+
+  return(true);
+}
+
+//
+// Publish current radio status for other tasks
+//
+static void radioPublish()
+{
+  RadioStatus *status = &radioStatus[(radioStatusSeq + 1) & 1];
+
+  status->freq         = freqToHz(currentFrequency, currentMode) + currentBFO;
+  status->bandIdx      = bandIdx;
+  status->modeIdx      = currentMode;
+  status->stepIdx      = bands[bandIdx].currentStepIdx;
+  status->bandwidthIdx = bands[bandIdx].bandwidthIdx;
+  status->rssi         = rssi;
+  status->snr          = snr;
+  status->rssiPeak     = signalGetPeak(SIGNAL_RSSI);
+  status->snrPeak      = signalGetPeak(SIGNAL_SNR);
+  status->agcIdx       = agcIdx;
+  status->agcNdx       = agcNdx;
+  status->volume       = volume;
+  status->squelch      = currentSquelch;
+  status->softMuteMaxAttIdx = softMuteMaxAttIdx;
+  status->avc          = isSSB()? SsbAvcIdx : AmAvcIdx;
+  status->piCode       = getRdsPiCode();
+  status->doneId       = radioDoneId;
+  status->failedId     = radioFailedId;
+
+  // Radio text is a sequence of zero-terminated strings
+  strlcpy(status->stationName, getStationName(), sizeof(status->stationName));
+  memcpy(status->radioText, getRadioText(), sizeof(status->radioText));
+  status->radioText[sizeof(status->radioText) - 2] = '\0';
+  status->radioText[sizeof(status->radioText) - 1] = '\0';
+  strlcpy(status->programInfo, getProgramInfo(), sizeof(status->programInfo));
+
+  __atomic_store_n(&radioStatusSeq, radioStatusSeq + 1, __ATOMIC_RELEASE);
+}
+
+//
+// Execute commands posted by other tasks and publish radio
+// status, returning true if any commands have been executed
+//
+bool radioTickTime()
+{
+  RadioCommand command;
+  bool executed = false;
+
+  while(radioQueue && xQueueReceive(radioQueue, &command, 0) == pdTRUE)
+  {
+    if(command.cmd == RADIO_CMD_DONE)
+    {
+      // Request complete, published with the status below
+      radioDoneId = command.a;
+      if(!radioOk) radioFailedId = command.a;
+      radioOk = true;
+    }
+    else
+    {
+      radioOk &= radioExecute(&command);
+      executed = true;
+    }
+  }
+
+  radioPublish();
+  return(executed);
+}
+
+//
+// Get a consistent copy of the radio status
+//
+void radioGetStatus(RadioStatus *status)
+{
+  uint32_t seq;
+
+  // Retry if the main loop published new status while copying
+  do
+  {
+    seq = __atomic_load_n(&radioStatusSeq, __ATOMIC_ACQUIRE);
+    memcpy(status, &radioStatus[seq & 1], sizeof(RadioStatus));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  }
+  while(seq != radioStatusSeq);
+}
@@ -0,0 +1,82 @@
+#ifndef RADIO_H
+#define RADIO_H
+
+#include <stdint.h>
+
+// Radio and settings commands posted to the main loop by other tasks
+#define RADIO_CMD_DONE        0  // a = request id, completes earlier commands
+#define RADIO_CMD_BAND        1  // a = band index
+#define RADIO_CMD_FREQ        2  // a = frequency (Hz)
+#define RADIO_CMD_STEP        3  // a = step index
+#define RADIO_CMD_BANDWIDTH   4  // a = bandwidth index
+#define RADIO_CMD_AGC         5  // a = AGC on/off, b = attenuation (either may be unset)
+#define RADIO_CMD_VOLUME      6  // a = volume
+#define RADIO_CMD_SQUELCH     7  // a = squelch level
+#define RADIO_CMD_SOFTMUTE    8  // a = soft mute max attenuation
+#define RADIO_CMD_AVC         9  // a = AVC level
+#define RADIO_CMD_MEMORY     10  // a = memory slot to tune to
+#define RADIO_CMD_CAL        11  // a = current band calibration
+#define RADIO_CMD_FMREGION   12  // a = FM region index
+#define RADIO_CMD_BRIGHTNESS 13  // a = display brightness
+#define RADIO_CMD_RDSMODE    14  // a = RDS mode index
+#define RADIO_CMD_UTCOFFSET  15  // a = UTC offset index
+#define RADIO_CMD_THEME      16  // a = theme index
+#define RADIO_CMD_UILAYOUT   17  // a = UI layout index
+#define RADIO_CMD_ZOOMMENU   18  // a = zoomed menu on/off
+#define RADIO_CMD_SCROLLDIR  19  // a = scroll direction (-1 or 1)
+#define RADIO_CMD_SLEEPMODE  20  // a = sleep mode index
+#define RADIO_CMD_SCREENSHOT 21  // Take screen snapshot for download
+
+#define RADIO_UNSET       INT32_MIN // Command argument not given
+#define RADIO_QUEUE_SIZE  32        // Maximal number of pending commands
+#define RADIO_BATCH_SIZE  16        // Maximal number of commands in a request
+
+typedef struct
+{
+  uint8_t cmd;
+  int32_t a;
+  int32_t b;
+} RadioCommand;
+
+// Radio state snapshot, safe to read from other tasks
+typedef struct
+{
+  uint32_t freq;              // Frequency, including BFO (Hz)
+  uint8_t  bandIdx;
+  uint8_t  modeIdx;
+  uint8_t  stepIdx;
+  uint8_t  bandwidthIdx;
+  uint8_t  rssi;
+  uint8_t  snr;
+  uint8_t  rssiPeak;
+  uint8_t  snrPeak;
+  int8_t   agcIdx;
+  int8_t   agcNdx;
+  uint8_t  volume;
+  uint8_t  squelch;
+  int8_t   softMuteMaxAttIdx;
+  int8_t   avc;
+  uint16_t piCode;
+  uint32_t doneId;            // Last completed request
+  uint32_t failedId;          // Last request with a failed command
+  char     stationName[50];
+  char     radioText[100];
+  char     programInfo[100];
+} RadioStatus;
+
+//
+// Commands of a single request, posted at once
+//
+typedef struct
+{
+  RadioCommand commands[RADIO_BATCH_SIZE];
+  uint8_t count;
+} RadioBatch;
+
+void radioInit();
+void radioAdd(RadioBatch *batch, uint8_t cmd, int32_t a = RADIO_UNSET, int32_t b = RADIO_UNSET);
+uint32_t radioPost(const RadioBatch *batch);
+bool radioTickTime();
+void radioGetStatus(RadioStatus *status);
+
+#endif // RADIO_H
@@ -0,0 +1,565 @@
+#include "Common.h"
+#include "Utils.h"
+#include "Menu.h"
+#include "Rds.h"
+#include "RdsLog.h"
+
+// Received character and its confidence
+typedef struct
+{
+  char c;
+  uint8_t conf;
+} RdsChar;
+
+// Decoder state for the current station
+static struct
+{
+  uint16_t pi;                  // Accepted PI code, 0 if none
+  uint16_t piCandidate;         // Last PI code seen with errors
+  uint8_t  pty;                 // Program type
+  bool     ptyValid;
+  RdsChar  ps[RDS_PS_LEN];
+  RdsChar  rt[RDS_RT_LEN];
+  RdsChar  ptyn[RDS_PTYN_LEN];
+  uint8_t  rtFlag;              // Radio text A/B flag (0xFF = unknown)
+  uint8_t  rtVersion;           // Radio text group version (0xFF = unknown)
+  uint8_t  rtLen;               // Radio text length, if end seen
+  uint8_t  ptynFlag;            // Program type name A/B flag
+  bool     ctNew;               // New clock time received
+  char     ct[8];               // Local time, as HH:MM
+} rds;
+
+// Alternative frequencies by station, least recently used replaced
+typedef struct
+{
+  uint16_t pi;                  // Station PI code, 0 if unused
+  uint8_t  count;               // Number of AF codes
+  uint8_t  codes[RDS_AF_MAX];   // AF codes, 87.6MHz + (code - 1) * 100kHz
+  uint32_t used;                // Last use, for replacement
+} RdsAfList;
+
+static RdsAfList rdsAf[RDS_AF_LISTS];
+static uint32_t rdsAfUsed = 0;
+static uint8_t rdsAfNext = 0;   // First AF to measure on the next check
+
+static RdsStats rdsStats;
+
+// Decoded strings, returned to the caller
+static char rdsStationName[RDS_PS_LEN + 1];
+static char rdsRadioText[RDS_RT_LEN + 1];
+static char rdsProgramTypeName[RDS_PTYN_LEN + 1];
+
+//
+// Clear all characters in a string
+//
+static void rdsClearChars(RdsChar *chars, uint8_t len)
+{
+  memset(chars, 0, len * sizeof(RdsChar));
+}
+
+//
+// Update a character, weighting the new value by its block error
+// level: repeats raise confidence, a different value must first
+// wear down the confidence of the current one
+//
+static void rdsUpdateChar(RdsChar *ch, uint8_t c, uint8_t ble)
+{
+  uint8_t weight = ble<3? 3 - ble : 0;
+
+  if(!weight) return;
+
+  if(ch->c == (char)c)
+    ch->conf = min(ch->conf + weight, RDS_CONF_MAX);
+  else if(ch->conf > weight)
+    ch->conf -= weight;
+  else
+  {
+    ch->c = c;
+    ch->conf = weight;
+  }
+}
+
+//
+// Update two characters from a block
+//
+static void rdsUpdatePair(RdsChar *chars, uint16_t block, uint8_t ble)
+{
+  rdsUpdateChar(&chars[0], block >> 8, ble);
+  rdsUpdateChar(&chars[1], block & 0xFF, ble);
+}
+
+//
+// Build a string from characters shown with enough confidence,
+// returns NULL if there are none (or some are missing, if
+// the whole string is required)
+//
+static const char *rdsGetChars(char *buf, const RdsChar *chars, uint8_t len, bool whole)
+{
+  bool any = false;
+
+  for(uint8_t i=0 ; i<len ; i++)
+  {
+    bool show = chars[i].conf >= RDS_CONF_SHOW;
+
+    if(!show && whole) return(0);
+    buf[i] = show? chars[i].c : ' ';
+    any |= show;
+  }
+
+  buf[len] = '\0';
+  return(any? buf : 0);
+}
+
+//
+// Accept a PI code if error free or seen twice in a row,
+// a new PI code means a different station
+//
+static void rdsUpdatePi(uint16_t pi, uint8_t ble)
+{
+  if(ble>1) return;
+
+  if(!ble || pi==rds.piCandidate)
+  {
+    if(rds.pi && pi!=rds.pi) rdsReset();
+    rds.pi = pi;
+  }
+
+  rds.piCandidate = pi;
+}
+
+//
+// Find AF list for the given station, optionally replacing the
+// least recently used one
+//
+static RdsAfList *rdsAfFind(uint16_t pi, bool create)
+{
+  RdsAfList *lru = &rdsAf[0];
+
+  for(int i=0 ; i<RDS_AF_LISTS ; i++)
+  {
+    if(rdsAf[i].pi==pi)
+    {
+      rdsAf[i].used = ++rdsAfUsed;
+      return(&rdsAf[i]);
+    }
+
+    if(rdsAf[i].used < lru->used) lru = &rdsAf[i];
+  }
+
+  if(!create) return(0);
+
+  lru->pi    = pi;
+  lru->count = 0;
+  lru->used  = ++rdsAfUsed;
+  return(lru);
+}
+
+//
+// Add AF code to the current station list
+//
+static void rdsAddAf(RdsAfList *af, uint8_t code)
+{
+  // Only VHF frequencies (LF/MF and list headers are skipped)
+  if(code<1 || code>204) return;
+
+  for(int i=0 ; i<af->count ; i++)
+    if(af->codes[i]==code) return;
+
+  if(af->count<RDS_AF_MAX) af->codes[af->count++] = code;
+}
+
+static inline uint16_t rdsAfFreq(uint8_t code)
+{
+  return(8750 + code * 10);
+}
+
+//
+// Group 0A/0B: program service name, alternative frequencies in 0A
+//
+static void rdsDecodePs(const uint16_t *blocks, const uint8_t *errors, uint8_t version)
+{
+  uint8_t addr = blocks[1] & 0x03;
+  rdsUpdatePair(&rds.ps[addr * 2], blocks[3], errors[3]);
+
+  // AF codes must be reliable and belong to a known station
+  if(version || errors[2]>1 || !rds.pi) return;
+
+  uint8_t hi = blocks[2] >> 8;
+  uint8_t lo = blocks[2] & 0xFF;
+
+  // Code 250 is followed by an LF/MF frequency
+  if(hi==250) return;
+
+  RdsAfList *af = rdsAfFind(rds.pi, true);
+  rdsAddAf(af, hi);
+  rdsAddAf(af, lo);
+}
+
+//
+// Group 2A/2B: radio text, 64 characters in 2A, 32 in 2B
+//
+static void rdsDecodeRt(const uint16_t *blocks, const uint8_t *errors, uint8_t version)
+{
+  uint8_t addr = blocks[1] & 0x0F;
+  uint8_t flag = (blocks[1] >> 4) & 0x01;
+  RdsChar *chars;
+
+  // Text A/B flag or group version change means new text
+  if(flag!=rds.rtFlag || version!=rds.rtVersion)
+  {
+    rdsClearChars(rds.rt, RDS_RT_LEN);
+    rds.rtFlag    = flag;
+    rds.rtVersion = version;
+    rds.rtLen     = version? RDS_RT_LEN / 2 : RDS_RT_LEN;
+  }
+
+  if(!version)
+  {
+    chars = &rds.rt[addr * 4];
+    rdsUpdatePair(chars, blocks[2], errors[2]);
+    rdsUpdatePair(chars + 2, blocks[3], errors[3]);
+  }
+  else
+  {
+    chars = &rds.rt[addr * 2];
+    rdsUpdatePair(chars, blocks[3], errors[3]);
+  }
+
+  // Text ends early at the first reliable carriage return
+  for(uint8_t i=0 ; i<rds.rtLen ; i++)
+    if(rds.rt[i].c==0x0D && rds.rt[i].conf>=RDS_CONF_SHOW)
+    {
+      rds.rtLen = i;
+      break;
+    }
+}
+
+//
+// Group 4A: clock time, converted to local time
+//
+static void rdsDecodeCt(const uint16_t *blocks, const uint8_t *errors)
+{
+  // Time must be exact
+  if(errors[1] || errors[2] || errors[3]) return;
+
+  uint8_t hours = ((blocks[2] & 0x01) << 4) | (blocks[3] >> 12);
+  uint8_t mins  = (blocks[3] >> 6) & 0x3F;
+  int offset    = (blocks[3] & 0x1F) * 30;
+
+  if(hours>=24 || mins>=60) return;
+
+  int time = hours * 60 + mins + (blocks[3] & 0x20? -offset : offset);
+  time = (time + 24 * 60) % (24 * 60);
+
+  sprintf(rds.ct, "%02d:%02d", time / 60, time % 60);
+  rds.ctNew = true;
+}
+
+//
+// Group 10A: program type name
+//
+static void rdsDecodePtyn(const uint16_t *blocks, const uint8_t *errors)
+{
+  uint8_t addr = blocks[1] & 0x01;
+  uint8_t flag = (blocks[1] >> 4) & 0x01;
+
+  if(flag!=rds.ptynFlag)
+  {
+    rdsClearChars(rds.ptyn, RDS_PTYN_LEN);
+    rds.ptynFlag = flag;
+  }
+
+  rdsUpdatePair(&rds.ptyn[addr * 4], blocks[2], errors[2]);
+  rdsUpdatePair(&rds.ptyn[addr * 4 + 2], blocks[3], errors[3]);
+}
+
+//
+// Decode a single RDS group
+//
+static void rdsDecodeGroup(const uint16_t *blocks, const uint8_t *errors)
+{
+  for(int i=0 ; i<4 ; i++) rdsStats.errors[i][errors[i] & 3]++;
+
+  // Group type is in block B, drop the group if it is unreliable
+  if(errors[1]>1)
+  {
+    rdsStats.dropped++;
+    return;
+  }
+
+  uint8_t type    = blocks[1] >> 11;
+  uint8_t version = type & 0x01;
+  rdsStats.types[type]++;
+
+  // PI code is in block A, and in block C of version B groups
+  rdsUpdatePi(blocks[0], errors[0]);
+  if(version) rdsUpdatePi(blocks[2], errors[2]);
+
+  rds.pty      = (blocks[1] >> 5) & 0x1F;
+  rds.ptyValid = true;
+
+  switch(type >> 1)
+  {
+    case 0:  rdsDecodePs(blocks, errors, version); break;
+    case 2:  rdsDecodeRt(blocks, errors, version); break;
+    case 4:  if(!version) rdsDecodeCt(blocks, errors); break;
+    case 10: if(!version) rdsDecodePtyn(blocks, errors); break;
+  }
+}
+
+//
+// Configure RDS reception, after the chip is set up for FM
+//
+void rdsInit()
+{
+  rx.sendProperty(0x1501, RDS_FIFO_COUNT); // FM_RDS_INT_FIFO_COUNT
+  rdsReset();
+}
+
+//
+// Forget current station data
+//
+void rdsReset()
+{
+  memset(&rds, 0, sizeof(rds));
+  rds.rtFlag    = 0xFF;
+  rds.rtVersion = 0xFF;
+  rds.ptynFlag  = 0xFF;
+}
+
+//
+// Drain all groups waiting in the chip FIFO and decode them,
+// returns the number of groups read
+//
+uint8_t rdsPoll()
+{
+  uint16_t blocks[4];
+  uint8_t errors[4];
+  uint8_t n = rx.getRdsFifoUsed();
+
+  rdsStats.polls++;
+  rdsStats.lost   += rx.getRdsGroupLost()? 1 : 0;
+  rdsStats.fifoMax = max(rdsStats.fifoMax, n);
+
+  n = min(n, (uint8_t)RDS_DRAIN_MAX);
+  for(uint8_t i=0 ; i<n ; i++)
+  {
+    rx.getRdsGroup(blocks, errors);
+    rdsStats.groups++;
+    rdsLogGroup(blocks, errors);
+    rdsDecodeGroup(blocks, errors);
+  }
+
+  return(n);
+}
+
+const char *rdsGetStationName()
+{
+  return(rdsGetChars(rdsStationName, rds.ps, RDS_PS_LEN, true));
+}
+
+const char *rdsGetRadioText()
+{
+  return(rdsGetChars(rdsRadioText, rds.rt, rds.rtLen, false));
+}
+
+const char *rdsGetProgramTypeName()
+{
+  return(rdsGetChars(rdsProgramTypeName, rds.ptyn, RDS_PTYN_LEN, true));
+}
+
+//
+// Returns local time received since the last call, or NULL
+//
+const char *rdsGetTime()
+{
+  if(!rds.ctNew) return(0);
+  rds.ctNew = false;
+  return(rds.ct);
+}
+
+uint8_t rdsGetProgramType()
+{
+  return(rds.ptyValid? rds.pty : 0);
+}
+
+uint16_t rdsGetPiCode()
+{
+  return(rds.pi);
+}
+
+//
+// Get current station alternative frequencies, returns their number
+//
+uint8_t rdsGetAfList(uint16_t *freqs)
+{
+  RdsAfList *af = rds.pi? rdsAfFind(rds.pi, false) : 0;
+  if(!af) return(0);
+
+  for(int i=0 ; i<af->count ; i++) freqs[i] = rdsAfFreq(af->codes[i]);
+  return(af->count);
+}
+
+//
+// Wait for a group from the station with the given PI code, returns
+// false if another station or no station is received in time
+//
+static bool rdsAfWaitPi(uint16_t pi, uint32_t budget)
+{
+  uint16_t blocks[4];
+  uint8_t errors[4];
+  uint32_t start = millis();
+
+  do
+  {
+    for(uint8_t n = rx.getRdsFifoUsed() ; n ; n--)
+    {
+      rx.getRdsGroup(blocks, errors);
+      if(errors[0]>1) continue;
+      if(blocks[0]==pi) return(true);
+      if(!errors[0]) return(false);
+    }
+
+    delay(5);
+  }
+  while(millis() - start < budget);
+
+  return(false);
+}
+
+//
+// Discard groups received from other stations
+//
+void rdsFlush()
+{
+  rx.clearRdsFifo();
+}
+
+//
+// When the signal gets weak, measure the current station alternative
+// frequencies and switch to the strongest one carrying the same PI.
+// The whole check, including tuning back, is kept within RDS_AF_GAP
+// of muted audio. Checks that find nothing back off the interval to
+// the next one, up to RDS_AF_BACKOFF. Returns true if the frequency
+// has changed.
+//
+bool rdsAfCheck(uint8_t rssi)
+{
+  static uint32_t lastCheck = 0;
+  static uint32_t interval = RDS_AF_INTERVAL;
+  static uint16_t lastPi = 0;
+  uint16_t freqs[RDS_AF_MAX];
+  uint8_t levels[RDS_AF_MAX];
+  uint8_t level, snr, n = 0;
+  bool found = false;
+
+  // Start over with a new station
+  if(rds.pi!=lastPi)
+  {
+    lastPi = rds.pi;
+    interval = RDS_AF_INTERVAL;
+  }
+
+  if(rssi>=RDS_AF_RSSI || !rds.pi || millis() - lastCheck < interval) return(false);
+
+  RdsAfList *af = rdsAfFind(rds.pi, false);
+  if(!af || !af->count) return(false);
+
+  uint16_t pi = rds.pi;
+  uint16_t origFreq = currentFrequency;
+  uint32_t start = millis();
+
+  rdsStats.afChecks++;
+  tempMuteOn(true);
+
+  // Measure AFs, continuing where the last check ran out of time
+  for(int i=0 ; i<af->count && millis() - start < RDS_AF_MEASURE ; i++)
+  {
+    uint16_t freq = rdsAfFreq(af->codes[rdsAfNext++ % af->count]);
+    if(freq==origFreq || !isFreqInBand(getCurrentBand(), freq)) continue;
+
+    rdsStats.afProbes++;
+    if(!scanProbe(freq, RDS_AF_PROBE, &level, &snr))
+      rdsStats.afTimeouts++;
+    else if(level>=rssi + RDS_AF_MARGIN)
+    {
+      freqs[n]    = freq;
+      levels[n++] = level;
+    }
+  }
+
+  // Try the strongest AFs first, until one carries the same PI,
+  // leaving time to tune to the AF and back within the gap
+  while(n && !found && millis() - start + 2 * RDS_AF_PROBE < RDS_AF_GAP)
+  {
+    int best = 0;
+    for(int i=1 ; i<n ; i++) if(levels[i]>levels[best]) best = i;
+
+    if(!scanProbe(freqs[best], RDS_AF_PROBE, &level, &snr))
+      rdsStats.afTimeouts++;
+    else
+    {
+      // Groups still in the FIFO came from the previous frequency
+      rdsFlush();
+      uint32_t spent = millis() - start;
+      found = spent + RDS_AF_PROBE < RDS_AF_GAP &&
+        rdsAfWaitPi(pi, RDS_AF_GAP - RDS_AF_PROBE - spent);
+    }
+
+    if(found)
+    {
+      updateFrequency(freqs[best], false);
+      rdsStats.afSwitches++;
+    }
+    else
+    {
+      freqs[best]  = freqs[--n];
+      levels[best] = levels[n];
+    }
+  }
+
+  // Return to the original frequency
+  if(!found && !scanProbe(origFreq, RDS_AF_PROBE, &level, &snr))
+    rdsStats.afTimeouts++;
+
+  rdsFlush();
+  if(!squelchCutoff) tempMuteOn(false);
+
+  uint32_t gap = millis() - start;
+  rdsStats.afGapMax = max(rdsStats.afGapMax, gap);
+  lastCheck = millis();
+
+  // Check less often while no AF helps
+  interval = found? RDS_AF_INTERVAL : min(interval * 2, (uint32_t)RDS_AF_BACKOFF);
+  return(found);
+}
+
+const RdsStats *rdsGetStats()
+{
+  return(&rdsStats);
+}
+
+//
+// Print RDS reception statistics to serial
+//
+void rdsPrintStats()
+{
+  Serial.printf("rds polls=%lu groups=%lu dropped=%lu lost=%lu fifo max=%u\r\n",
+    rdsStats.polls, rdsStats.groups, rdsStats.dropped, rdsStats.lost, rdsStats.fifoMax
+  );
+
+  Serial.print("rds types");
+  for(int i=0 ; i<32 ; i++)
+    if(rdsStats.types[i])
+      Serial.printf(" %d%c=%lu", i >> 1, i & 1? 'B' : 'A', rdsStats.types[i]);
+  Serial.println();
+
+  Serial.printf("rds af checks=%lu probes=%lu switches=%lu timeouts=%lu gap max=%lums\r\n",
+    rdsStats.afChecks, rdsStats.afProbes, rdsStats.afSwitches, rdsStats.afTimeouts, rdsStats.afGapMax
+  );
+
+  for(int i=0 ; i<4 ; i++)
+    Serial.printf("rds block %c errors %lu %lu %lu %lu\r\n", 'A' + i,
+      rdsStats.errors[i][0], rdsStats.errors[i][1], rdsStats.errors[i][2], rdsStats.errors[i][3]
+    );
+}
@@ -0,0 +1,59 @@
+#ifndef RDS_H
+#define RDS_H
+
+#include <stdint.h>
+
+#define RDS_FIFO_COUNT    4   // Groups in the chip FIFO that set RDSRECV
+#define RDS_DRAIN_MAX    25   // Most groups read per poll (chip FIFO size)
+
+#define RDS_CONF_MAX      6   // Highest character confidence
+#define RDS_CONF_SHOW     2   // Confidence needed to show a character
+
+#define RDS_PS_LEN        8   // Program service name
+#define RDS_RT_LEN       64   // Radio text
+#define RDS_PTYN_LEN      8   // Program type name
+
+#define RDS_AF_LISTS      8   // Stations with alternative frequencies kept
+#define RDS_AF_MAX       25   // Alternative frequencies kept per station
+#define RDS_AF_RSSI      20   // Check AFs when RSSI drops below (dBuV)
+#define RDS_AF_MARGIN     6   // AF must be stronger by this much (dB)
+#define RDS_AF_INTERVAL 10000 // Shortest time between AF checks (ms)
+#define RDS_AF_BACKOFF  80000 // Longest time between AF checks finding nothing (ms)
+#define RDS_AF_PROBE    TUNE_DELAY_FM // Time budget for tuning to an AF (ms)
+#define RDS_AF_MEASURE  120   // Time budget for measuring AFs (ms)
+#define RDS_AF_GAP      350   // Longest audio gap of an AF check (ms)
+
+typedef struct
+{
+  uint32_t polls;             // Times the FIFO has been drained
+  uint32_t groups;            // Groups read
+  uint32_t dropped;           // Groups dropped for an unreliable block B
+  uint32_t lost;              // Polls finding that the chip FIFO overflowed
+  uint8_t  fifoMax;           // Most groups found in the FIFO at once
+  uint32_t types[32];         // Groups by type (0A, 0B, 1A, 1B, ...)
+  uint32_t errors[4][4];      // Blocks A-D by error level (0-3)
+  uint32_t afChecks;          // AF checks done
+  uint32_t afProbes;          // AFs measured
+  uint32_t afSwitches;        // Switches to a stronger AF
+  uint32_t afTimeouts;        // AFs not tuned within the probe budget
+  uint32_t afGapMax;          // Longest audio gap during AF check (ms)
+} RdsStats;
+
+void rdsInit();
+void rdsReset();
+uint8_t rdsPoll();
+void rdsFlush();
+
+const char *rdsGetStationName();
+const char *rdsGetRadioText();
+const char *rdsGetProgramTypeName();
+const char *rdsGetTime();
+uint8_t rdsGetProgramType();
+uint16_t rdsGetPiCode();
+uint8_t rdsGetAfList(uint16_t *freqs);
+bool rdsAfCheck(uint8_t rssi);
+
+const RdsStats *rdsGetStats();
+void rdsPrintStats();
+
+#endif // RDS_H
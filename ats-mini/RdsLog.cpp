@@ -0,0 +1,424 @@
+#include "Common.h"
+#include "RdsLog.h"
+
+#include <LittleFS.h>
+#include <ESPAsyncWebServer.h>
+
+// Groups received since the last send and save
+static RdsLogRecord rdsLogQueue[RDS_LOG_QUEUE];
+static uint16_t rdsLogCount = 0;      // Queued records
+static uint16_t rdsLogSent  = 0;      // Queued records already sent
+static uint32_t rdsLogSendTime = 0;
+static uint32_t rdsLogSaveTime = 0;
+
+// Capture file, open while capturing or until the last records
+// can be saved after stopping
+static bool rdsLogActive = false;
+static bool rdsLogClosing = false;
+static fs::File rdsLogFile;
+static RdsLogHeader rdsLogHdr;
+
+// Last download activity (ms), written by the web server task
+static volatile uint32_t rdsLogReadTime = 0;
+static volatile bool rdsLogReadAny = false;
+
+// Held while saving or replacing the capture file and while taking
+// a download snapshot, so saves never wrap over a new download
+static SemaphoreHandle_t rdsLogLock = 0;
+
+// Group stream clients
+static AsyncWebSocket rdsLogWs("/ws/rds");
+
+static struct
+{
+  uint32_t groups;                    // Groups queued
+  uint32_t dropped;                   // Groups dropped, queue full
+  uint32_t wsDropped;                 // Groups not sent, clients busy
+  uint32_t saves;                     // Capture file writes
+} rdsLogStats;
+
+//
+// Format a group as an RDS Spy text line, uncorrectable blocks
+// are shown as "----"
+//
+static void rdsLogSpyLine(char *p, const RdsLogRecord *rec)
+{
+  static const char hex[] = "0123456789ABCDEF";
+
+  for(int i=0 ; i<4 ; i++, p+=5)
+  {
+    uint16_t block = rec->blocks[i];
+
+    if(((rec->errors >> (6 - i * 2)) & 3) == 3)
+      memcpy(p, "----", 4);
+    else
+    {
+      p[0] = hex[block >> 12];
+      p[1] = hex[(block >> 8) & 15];
+      p[2] = hex[(block >> 4) & 15];
+      p[3] = hex[block & 15];
+    }
+
+    p[4] = i<3? ' ' : '\r';
+  }
+
+  *p = '\n';
+}
+
+//
+// Send queued records to the serial port (as RDS Spy text, while
+// capturing) and to the WebSocket clients (as binary records)
+//
+static void rdsLogSend()
+{
+  const RdsLogRecord *recs = &rdsLogQueue[rdsLogSent];
+  uint16_t n = rdsLogCount - rdsLogSent;
+
+  if(rdsLogActive)
+  {
+    char lines[16 * RDS_LOG_SPY_LINE];
+
+    for(uint16_t i=0 ; i<n ; )
+    {
+      size_t len = 0;
+      for(int j=0 ; j<16 && i<n ; j++, i++, len+=RDS_LOG_SPY_LINE)
+        rdsLogSpyLine(lines + len, &recs[i]);
+      Serial.write(lines, len);
+    }
+  }
+
+  if(rdsLogWs.count())
+  {
+    rdsLogWs.cleanupClients();
+
+    // Drop records rather than wait while clients are busy
+    if(rdsLogWs.availableForWriteAll())
+      rdsLogWs.binaryAll((uint8_t *)recs, n * sizeof(RdsLogRecord));
+    else
+      rdsLogStats.wsDropped += n;
+  }
+
+  rdsLogSent = rdsLogCount;
+  rdsLogSendTime = millis();
+}
+
+//
+// Append queued records to the capture file ring, overwriting
+// the oldest records when the ring is full
+//
+static void rdsLogSave()
+{
+  uint32_t pos = (rdsLogHdr.head + rdsLogHdr.count) % rdsLogHdr.capacity;
+
+  for(uint16_t i=0 ; i<rdsLogCount ; )
+  {
+    uint32_t n = rdsLogHdr.capacity - pos;
+    if(n > (uint32_t)(rdsLogCount - i)) n = rdsLogCount - i;
+
+    rdsLogFile.seek(sizeof(RdsLogHeader) + pos * sizeof(RdsLogRecord));
+    rdsLogFile.write((const uint8_t *)&rdsLogQueue[i], n * sizeof(RdsLogRecord));
+
+    if(rdsLogHdr.count + n > rdsLogHdr.capacity)
+    {
+      rdsLogHdr.head  = (rdsLogHdr.head + rdsLogHdr.count + n - rdsLogHdr.capacity) % rdsLogHdr.capacity;
+      rdsLogHdr.count = rdsLogHdr.capacity;
+    }
+    else
+      rdsLogHdr.count += n;
+
+    pos = (pos + n) % rdsLogHdr.capacity;
+    i += n;
+  }
+
+  rdsLogFile.seek(0);
+  rdsLogFile.write((const uint8_t *)&rdsLogHdr, sizeof(rdsLogHdr));
+  rdsLogFile.flush();
+
+  rdsLogStats.saves++;
+  rdsLogCount = rdsLogSent = 0;
+  rdsLogSaveTime = millis();
+}
+
+//
+// True while a capture download may be running
+//
+static bool rdsLogReading()
+{
+  uint32_t last = rdsLogReadTime;
+  return(rdsLogReadAny && millis() - last < RDS_LOG_READ_IDLE);
+}
+
+//
+// Saving queued records is held back while they would wrap the
+// ring over records that a running download has yet to read
+//
+static bool rdsLogSaveBlocked()
+{
+  return(rdsLogReading() && rdsLogHdr.count + rdsLogCount > rdsLogHdr.capacity);
+}
+
+static void rdsLogLockTake()
+{
+  if(rdsLogLock) xSemaphoreTake(rdsLogLock, portMAX_DELAY);
+}
+
+static void rdsLogLockGive()
+{
+  if(rdsLogLock) xSemaphoreGive(rdsLogLock);
+}
+
+//
+// Save queued records, unless that has to wait for a download.
+// Returns false if saving has been held back.
+//
+static bool rdsLogTrySave()
+{
+  rdsLogLockTake();
+  bool blocked = rdsLogSaveBlocked();
+  if(!blocked) rdsLogSave();
+  rdsLogLockGive();
+
+  return(!blocked);
+}
+
+//
+// Save the last records and close the capture file, once saving
+// is no longer held back
+//
+static void rdsLogTryClose()
+{
+  if(!rdsLogTrySave()) return;
+  rdsLogFile.close();
+  rdsLogClosing = false;
+}
+
+//
+// Get or set RDS capture state. Starting a capture replaces the
+// previous capture file, which is refused while it is downloaded.
+//
+bool rdsLogOn(int x)
+{
+  if(x==1 && !rdsLogActive)
+  {
+    if(rdsLogClosing) rdsLogTryClose();
+    if(rdsLogClosing) return(false);
+
+    rdsLogLockTake();
+    if(rdsLogReading())
+    {
+      rdsLogLockGive();
+      return(false);
+    }
+
+    // Records queued for the WebSocket clients only
+    if(rdsLogSent < rdsLogCount) rdsLogSend();
+    rdsLogCount = rdsLogSent = 0;
+
+    rdsLogFile = LittleFS.open(RDS_LOG_PATH, "w+");
+    if(!rdsLogFile)
+    {
+      rdsLogLockGive();
+      return(false);
+    }
+
+    memset(&rdsLogHdr, 0, sizeof(rdsLogHdr));
+    memcpy(rdsLogHdr.magic, "ATSR", 4);
+    rdsLogHdr.version    = RDS_LOG_VERSION;
+    rdsLogHdr.recordSize = sizeof(RdsLogRecord);
+    rdsLogHdr.capacity   = RDS_LOG_RECORDS;
+    rdsLogFile.write((const uint8_t *)&rdsLogHdr, sizeof(rdsLogHdr));
+    rdsLogLockGive();
+
+    rdsLogActive = true;
+    rdsLogSendTime = rdsLogSaveTime = millis();
+  }
+  else if(x==0 && rdsLogActive)
+  {
+    if(rdsLogSent < rdsLogCount) rdsLogSend();
+    rdsLogActive = false;
+
+    // Finish later if saving has to wait for a download
+    rdsLogClosing = true;
+    rdsLogTryClose();
+  }
+
+  return(rdsLogActive);
+}
+
+//
+// Queue a received group, while capturing or streaming it
+//
+void rdsLogGroup(const uint16_t *blocks, const uint8_t *errors)
+{
+  // Streamed groups are not queued while the capture is closing,
+  // they would end up in the capture file
+  if(!rdsLogActive && (rdsLogClosing || !rdsLogWs.count())) return;
+
+  if(rdsLogCount >= RDS_LOG_QUEUE)
+  {
+    rdsLogStats.dropped++;
+    return;
+  }
+
+  RdsLogRecord *rec = &rdsLogQueue[rdsLogCount++];
+  rec->time   = millis();
+  rec->errors = 0;
+  for(int i=0 ; i<4 ; i++)
+  {
+    rec->blocks[i] = blocks[i];
+    rec->errors = (rec->errors << 2) | (errors[i] & 3);
+  }
+
+  rdsLogStats.groups++;
+}
+
+//
+// Tick RDS capture time, sending and saving queued groups in
+// batches to keep the main loop timing steady
+//
+void rdsLogTickTime()
+{
+  uint32_t now = millis();
+  uint16_t unsent = rdsLogCount - rdsLogSent;
+
+  if(unsent && (unsent >= RDS_LOG_SEND || now - rdsLogSendTime >= RDS_LOG_SEND_TIME))
+    rdsLogSend();
+
+  if(rdsLogClosing)
+  {
+    rdsLogTryClose();
+    return;
+  }
+
+  if(!rdsLogActive)
+  {
+    // Streaming only, nothing to keep
+    if(rdsLogSent == rdsLogCount) rdsLogCount = rdsLogSent = 0;
+    return;
+  }
+
+  // While saving is held back, records keep queueing and are
+  // dropped once the queue is full
+  if(rdsLogCount && (rdsLogCount >= RDS_LOG_SAVE || now - rdsLogSaveTime >= RDS_LOG_SAVE_TIME))
+  {
+    if(rdsLogSent < rdsLogCount) rdsLogSend();
+    rdsLogTrySave();
+  }
+}
+
+//
+// Print RDS capture statistics to serial
+//
+void rdsLogPrintStats()
+{
+  Serial.printf("rds capture %s groups=%lu dropped=%lu ws dropped=%lu saves=%lu records=%lu\r\n",
+    rdsLogActive? "on" : "off", rdsLogStats.groups, rdsLogStats.dropped,
+    rdsLogStats.wsDropped, rdsLogStats.saves, rdsLogActive? rdsLogHdr.count : 0
+  );
+}
+
+//
+// Take a snapshot of the capture file state, to be kept by the
+// download and passed to rdsLogRead(). Returns the download size
+// (0 if no capture).
+//
+size_t rdsLogSnapshot(RdsLogHeader *snap, bool spy)
+{
+  rdsLogLockTake();
+
+  fs::File file = LittleFS.open(RDS_LOG_PATH, "rb");
+  size_t len = file? file.read((uint8_t *)snap, sizeof(*snap)) : 0;
+  if(file) file.close();
+
+  bool valid = len==sizeof(*snap) && !memcmp(snap->magic, "ATSR", 4) &&
+    snap->recordSize==sizeof(RdsLogRecord) && snap->capacity;
+
+  // Hold back ring wraps and new captures from now on
+  if(valid)
+  {
+    rdsLogReadTime = millis();
+    rdsLogReadAny  = true;
+  }
+
+  rdsLogLockGive();
+  if(!valid) return(0);
+
+  if(spy) return(snap->count * RDS_LOG_SPY_LINE);
+  return(sizeof(RdsLogHeader) + snap->count * sizeof(RdsLogRecord));
+}
+
+//
+// Fill buffer with the captured groups in the snapshot, oldest
+// first, starting at given index. The binary capture starts with
+// a header, the text one has a line per group. Return the number
+// of bytes written.
+//
+size_t rdsLogRead(const RdsLogHeader *snap, uint8_t *buf, size_t maxLen, size_t index, bool spy)
+{
+  size_t hdrSize = spy? 0 : sizeof(RdsLogHeader);
+  size_t recSize = spy? RDS_LOG_SPY_LINE : sizeof(RdsLogRecord);
+  size_t size = hdrSize + snap->count * recSize;
+  size_t len = 0;
+
+  if(index >= size) return(0);
+  if(maxLen > size - index) maxLen = size - index;
+  rdsLogReadTime = millis();
+
+  fs::File file = LittleFS.open(RDS_LOG_PATH, "rb");
+  if(!file) return(0);
+
+  // Header, with the ring unrolled
+  if(index < hdrSize)
+  {
+    RdsLogHeader header = *snap;
+    header.capacity = header.count;
+    header.head = 0;
+    len = hdrSize - index < maxLen? hdrSize - index : maxLen;
+    memcpy(buf, (const uint8_t *)&header + index, len);
+  }
+
+  for(index += len ; len < maxLen ; )
+  {
+    size_t offset = index - hdrSize;
+    uint32_t phys = (snap->head + offset / recSize) % snap->capacity;
+    size_t pos = offset % recSize;
+    size_t n;
+
+    if(spy)
+    {
+      RdsLogRecord rec;
+      char line[RDS_LOG_SPY_LINE];
+
+      file.seek(sizeof(RdsLogHeader) + phys * sizeof(RdsLogRecord));
+      if(file.read((uint8_t *)&rec, sizeof(rec)) != sizeof(rec)) break;
+
+      rdsLogSpyLine(line, &rec);
+      n = recSize - pos < maxLen - len? recSize - pos : maxLen - len;
+      memcpy(buf + len, line + pos, n);
+    }
+    else
+    {
+      // Read up to the end of the ring at once
+      n = (snap->capacity - phys) * recSize - pos;
+      if(n > maxLen - len) n = maxLen - len;
+
+      file.seek(sizeof(RdsLogHeader) + phys * recSize + pos);
+      if(file.read(buf + len, n) != n) break;
+    }
+
+    len   += n;
+    index += n;
+  }
+
+  file.close();
+  return(len);
+}
+
+//
+// Register RDS group stream WebSocket with the web server
+//
+void rdsLogInit(AsyncWebServer &server)
+{
+  if(!rdsLogLock) rdsLogLock = xSemaphoreCreateMutex();
+  server.addHandler(&rdsLogWs);
+}
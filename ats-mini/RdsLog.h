@@ -0,0 +1,57 @@
+#ifndef RDSLOG_H
+#define RDSLOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RDS_LOG_PATH      "/rds.bin"
+#define RDS_LOG_VERSION   1
+#define RDS_LOG_RECORDS   16384 // Capture file ring size (records)
+#define RDS_LOG_QUEUE     128   // Records queued in memory between writes
+#define RDS_LOG_SEND      32    // Send queued records when this many wait
+#define RDS_LOG_SAVE      96    // Save queued records when this many wait
+#define RDS_LOG_SEND_TIME 250   // Longest time records wait to be sent (ms)
+#define RDS_LOG_SAVE_TIME 2000  // Longest time records wait to be saved (ms)
+#define RDS_LOG_READ_IDLE 3000  // Download assumed over after no reads for (ms)
+
+// RDS Spy text line: four HEX blocks, CR LF
+#define RDS_LOG_SPY_LINE  (4 * 5 + 1)
+
+//
+// Captured RDS group. Block error levels are packed two bits per
+// block, block A in the top bits. Level 3 means uncorrectable.
+//
+typedef struct __attribute__((packed))
+{
+  uint32_t time;          // Time the group was read (ms since boot)
+  uint16_t blocks[4];     // Blocks A-D
+  uint8_t errors;         // Block error levels
+} RdsLogRecord;
+
+//
+// Capture file header, followed by the ring of records. The oldest
+// record is at index head, the downloaded capture always has head=0.
+//
+typedef struct __attribute__((packed))
+{
+  char magic[4];          // "ATSR"
+  uint8_t version;        // RDS_LOG_VERSION
+  uint8_t recordSize;     // sizeof(RdsLogRecord)
+  uint16_t reserved;
+  uint32_t capacity;      // Records the ring holds
+  uint32_t head;          // Index of the oldest record
+  uint32_t count;         // Number of records
+} RdsLogHeader;
+
+bool rdsLogOn(int x = 2);
+void rdsLogGroup(const uint16_t *blocks, const uint8_t *errors);
+void rdsLogTickTime();
+void rdsLogPrintStats();
+
+size_t rdsLogSnapshot(RdsLogHeader *snap, bool spy);
+size_t rdsLogRead(const RdsLogHeader *snap, uint8_t *buf, size_t maxLen, size_t index, bool spy);
+
+class AsyncWebServer;
+void rdsLogInit(AsyncWebServer &server);
+
+#endif // RDSLOG_H
@@ -3,9 +3,17 @@
 #include "Utils.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Perf.h"
+#include "Capture.h"
+#include "Rds.h"
+#include "RdsLog.h"
+#include "Signal.h"
 
 #ifndef DISABLE_REMOTE
 
+// Band switch benchmark passes over all AM bands
+#define BENCH_ROUNDS 3
+
 static uint32_t remoteTimer = millis();
 static uint8_t remoteSeqnum = 0;
 static bool remoteLogOn = false;
@@ -18,48 +26,6 @@ static uint8_t char2nibble(char key)
   return(0);
 }
 
-//
-// Capture current screen image to the remote
-//
-static void remoteCaptureScreen()
-{
-  uint16_t width  = spr.width();
-  uint16_t height = spr.height();
-
-  // 14 bytes of BMP header
-  Serial.println("");
-  Serial.print("424d"); // BM
-  // Image size
-  Serial.printf("%08x", (unsigned int)htonl(14 + 40 + 12 + width * height * 2));
-  Serial.print("00000000");
-  // Offset to image data
-  Serial.printf("%08x", (unsigned int)htonl(14 + 40 + 12));
-  // Image header
-  Serial.print("28000000"); // Header size
-  Serial.printf("%08x", (unsigned int)htonl(width));
-  Serial.printf("%08x", (unsigned int)htonl(height));
-  Serial.print("01001000"); // 1 plane, 16 bpp
-  Serial.print("03000000"); // Compression
-  Serial.print("00000000"); // Compressed image size
-  Serial.print("00000000"); // X res
-  Serial.print("00000000"); // Y res
-  Serial.print("00000000"); // Color map
-  Serial.print("00000000"); // Colors
-  Serial.print("00f80000"); // Red mask
-  Serial.print("e0070000"); // Green mask
-  Serial.println("1f000000"); // Blue mask
-
-  // Image data
-  for(int y=height-1 ; y>=0 ; y--)
-  {
-    for(int x=0 ; x<width ; x++)
-    {
-      Serial.printf("%04x", htons(spr.readPixel(x, y)));
-    }
-    Serial.println("");
-  }
-}
-
 char readSerialChar()
 {
   char key;
@@ -258,18 +224,95 @@ static void remoteGetColorTheme()
   Serial.println();
 }
 
+//
+// Print SI4735 property shadow and patch statistics to the remote
+//
+static void remoteGetDiagnostics()
+{
+  static const char *names[SHADOW_STATS] = { "total", "band", "tune", "watch" };
+
+  for(int i=0 ; i<SHADOW_STATS ; i++)
+  {
+    const ShadowStats *st = rx.getShadowStats(i);
+    uint32_t writes = st->issued + st->saved;
+
+    Serial.printf("shadow %-5s count=%lu issued=%lu saved=%lu (%lu%%)",
+      names[i], st->count, st->issued, st->saved, writes? st->saved * 100 / writes : 0
+    );
+
+    if(i!=SHADOW_TOTAL && st->count)
+      Serial.printf(" issued/op=%lu.%02lu",
+        st->issued / st->count, st->issued * 100 / st->count % 100
+      );
+
+    Serial.println();
+  }
+
+  Serial.printf("signal interval=%lums rssi=%u peak=%u dev=%u snr=%u peak=%u dev=%u\r\n",
+    signalGetInterval(),
+    signalGet(SIGNAL_RSSI), signalGetPeak(SIGNAL_RSSI), signalGetDeviation(SIGNAL_RSSI),
+    signalGet(SIGNAL_SNR), signalGetPeak(SIGNAL_SNR), signalGetDeviation(SIGNAL_SNR)
+  );
+
+  printSSBLoad();
+  memScanPrintStats();
+  prioWatchPrintStats();
+  rdsPrintStats();
+  rdsLogPrintStats();
+}
+
+//
+// Measure band switch times between all AM bands, then
+// return to the original band
+//
+static void remoteBandBenchmark()
+{
+  int origBandIdx = bandIdx;
+  uint32_t count = 0, total = 0, audio = 0, minTime = UINT32_MAX, maxTime = 0;
+  bool first = true;
+
+  for(int round=0 ; round<BENCH_ROUNDS ; round++)
+  {
+    for(int i=0 ; i<getTotalBands() ; i++)
+    {
+      if(bands[i].bandMode!=AM || i==bandIdx) continue;
+
+      // Switching from the original band may change mode, skip it
+      switchBand(i);
+      if(first) { first = false; continue; }
+
+      uint32_t audioTime;
+      uint32_t time = getBandSwitchTime(&audioTime);
+
+      count++;
+      total  += time;
+      audio  += audioTime;
+      minTime = min(minTime, time);
+      maxTime = max(maxTime, time);
+    }
+  }
+
+  switchBand(origBandIdx);
+
+  if(!count)
+    Serial.println("Band benchmark: need at least two AM bands");
+  else
+    Serial.printf("Band benchmark: AM<->AM switches=%lu min=%lums avg=%lums max=%lums audio avg=%lums\r\n",
+      count, minTime / 1000, total / count / 1000, maxTime / 1000, audio / count / 1000
+    );
+}
+
 //
 // Print current status to the remote
 //
 void remotePrintStatus()
 {
   // Prepare information ready to be sent
-  float remoteVoltage = batteryMonitor();
+  float remoteVoltage = batteryGetVolts();
 
-  // S-Meter conditional on compile option
-  rx.getCurrentReceivedSignalQuality();
-  uint8_t remoteRssi = rx.getCurrentRSSI();
-  uint8_t remoteSnr = rx.getCurrentSNR();
+  // Filtered signal values, no need to query the chip
+  uint8_t remoteRssi = rssi;
+  uint8_t remoteSnr = snr;
 
   // Use rx.getFrequency to force read of capacitor value from SI4732/5
   rx.getFrequency();
@@ -315,6 +358,8 @@ void remoteTickTime()
 //
 int remoteDoCommand(char key)
 {
+  PERF_TRACE(PERF_TRACE_REMOTE);
+
   int event = 0;
 
   switch(key)
@@ -402,7 +447,11 @@ int remoteDoCommand(char key)
       break;
     case 'C':
       remoteLogOn = false;
-      remoteCaptureScreen();
+      captureSerialHex();
+      break;
+    case 'c':
+      remoteLogOn = false;
+      captureSerialRle();
       break;
     case 't':
       remoteLogOn = !remoteLogOn;
@@ -425,6 +474,29 @@ int remoteDoCommand(char key)
     case '@':
       if(switchThemeEditor()) remoteGetColorTheme();
       break;
+    case 'd':
+      remoteGetDiagnostics();
+      break;
+    case 'Z':
+      remoteBandBenchmark();
+      break;
+    case 'Y':
+      if(prioWatchOn()) prioWatchStop(); else prioWatchStart();
+      Serial.println(prioWatchOn() ? "Priority watch enabled" : "Priority watch disabled");
+      break;
+    case 'G':
+      remoteLogOn = false;
+      Serial.println(rdsLogOn(!rdsLogOn()) ? "RDS capture enabled" : "RDS capture disabled");
+      break;
+
+#ifdef ENABLE_PERF
+    case 'P':
+      Serial.println(perfOverlayOn(!perfOverlayOn()) ? "Perf overlay enabled" : "Perf overlay disabled");
+      break;
+    case 'p':
+      perfPrint();
+      break;
+#endif
 
     default:
       // Command not recognized
@@ -1,8 +1,353 @@
 #include <SI4735.h>
+#include "Perf.h"
+
+// Longest wait for CTS while loading a patch (us), including the
+// power up, which waits for the crystal oscillator to start
+#define PATCH_CTS_TIMEOUT  500000
+
+// Property shadow size and keys for shadowed commands
+#define SHADOW_SIZE        24
+#define SHADOW_GPIO_CTL    0xF080 // GPIO_CTL command
+#define SHADOW_GPIO_SET    0xF081 // GPIO_SET command
+
+// Property shadow statistics
+#define SHADOW_TOTAL       0  // All writes
+#define SHADOW_BAND        1  // Writes per band switch
+#define SHADOW_TUNE        2  // Writes per tuning step
+#define SHADOW_WATCH       3  // Writes per priority channel check
+#define SHADOW_STATS       4
+
+typedef struct
+{
+  uint32_t count;   // Number of operations (band switches, tuning steps)
+  uint32_t issued;  // Writes sent to the chip
+  uint32_t saved;   // Writes skipped because the chip already has the value
+} ShadowStats;
 
 class SI4735_fixed: public SI4735
 {
+  private:
+    // Last values written to the chip, forgotten on power up
+    uint16_t shadowKeys[SHADOW_SIZE];
+    uint32_t shadowValues[SHADOW_SIZE];
+    uint8_t shadowCount = 0;
+    bool shadowAM = false;
+    ShadowStats shadowStats[SHADOW_STATS] = {};
+    ShadowStats shadowMark = {};
+
+    // Last SSB patch load
+    uint32_t patchTime = 0;
+    uint32_t patchLoads = 0;
+    bool patchOk = false;
+
+    // SSB patch is in the chip, until it is powered up again
+    bool patchResident = false;
+
+    // Patch firmware demodulates AM in SYNC mode
+    bool syncAM = false;
+
+    // Poll status until the chip is clear to send, false on error or timeout
+    bool patchWaitToSend()
+    {
+      uint32_t start = micros();
+
+      do
+      {
+        if(Wire.requestFrom((uint8_t)deviceAddress, (uint8_t)1)!=1) return(false);
+        uint8_t status = Wire.read();
+        if(status & 0x40) return(false); // ERR
+        if(status & 0x80) return(true);  // CTS
+      }
+      while(micros() - start < PATCH_CTS_TIMEOUT);
+
+      return(false);
+    }
+
+    // Returns true if the value is already in the chip, otherwise records it
+    bool shadowSkip(uint16_t key, uint32_t value)
+    {
+      uint8_t i;
+
+      for(i=0 ; i<shadowCount && shadowKeys[i]!=key ; i++);
+
+      if(i<shadowCount && shadowValues[i]==value)
+      {
+        shadowStats[SHADOW_TOTAL].saved++;
+        return(true);
+      }
+
+      if(i<SHADOW_SIZE)
+      {
+        shadowKeys[i]   = key;
+        shadowValues[i] = value;
+        shadowCount     = i<shadowCount? shadowCount : i + 1;
+      }
+
+      shadowStats[SHADOW_TOTAL].issued++;
+      return(false);
+    }
+
   public:
+    //
+    // Property shadow: skip writing properties (and a few commands)
+    // that would not change the chip state. The shadow is invalidated
+    // whenever the chip is powered up, which resets its properties.
+    //
+    void shadowInvalidate() { shadowCount = 0; shadowAM = false; }
+
+    // Start counting writes for a band switch or a tuning step
+    void shadowBegin() { shadowMark = shadowStats[SHADOW_TOTAL]; }
+
+    // Account writes done since shadowBegin() to the given statistics
+    void shadowEnd(uint8_t stats)
+    {
+      shadowStats[stats].count++;
+      shadowStats[stats].issued += shadowStats[SHADOW_TOTAL].issued - shadowMark.issued;
+      shadowStats[stats].saved  += shadowStats[SHADOW_TOTAL].saved - shadowMark.saved;
+    }
+
+    const ShadowStats *getShadowStats(uint8_t stats)
+    {
+      return(stats<SHADOW_STATS? &shadowStats[stats] : 0);
+    }
+
+    // Power up and patch loading reset all properties, power up
+    // also drops the SSB patch
+    using SI4735::setup;
+    void setup(uint8_t resetPin, uint8_t defaultFunction)
+    {
+      shadowInvalidate();
+      patchResident = syncAM = false;
+      SI4735::setup(resetPin, defaultFunction);
+    }
+
+    using SI4735::setFM;
+    void setFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step)
+    {
+      shadowInvalidate();
+      patchResident = syncAM = false;
+      SI4735::setFM(fromFreq, toFreq, initialFreq, step);
+    }
+
+    // Switching between AM bands does not power cycle the chip,
+    // switching from another mode does
+    using SI4735::setAM;
+    void setAM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step)
+    {
+      if(!shadowAM)
+      {
+        shadowInvalidate();
+        patchResident = syncAM = false;
+      }
+      SI4735::setAM(fromFreq, toFreq, initialFreq, step);
+      shadowAM = true;
+    }
+
+    using SI4735::setSSB;
+    void setSSB(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step, uint8_t usblsb)
+    {
+      shadowInvalidate();
+      SI4735::setSSB(fromFreq, toFreq, initialFreq, step, usblsb);
+
+      // Back from SYNC mode to SSB, the caller sets the bandwidth
+      if(syncAM)
+      {
+        setSSBConfig(1, 1, 0, 1, 0, 1);
+        syncAM = false;
+      }
+    }
+
+    // Shadowed property setters
+    void setVolume(uint8_t volume)
+    {
+      if(shadowSkip(0x4000, volume)) return;  // RX_VOLUME
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setVolume(volume);
+    }
+
+    void setFMDeEmphasis(uint8_t parameter)
+    {
+      if(shadowSkip(0x1100, parameter)) return;  // FM_DEEMPHASIS
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setFMDeEmphasis(parameter);
+    }
+
+    void setAvcAmMaxGain(uint8_t gain)
+    {
+      if(shadowSkip(0x3103, gain)) return;  // AM_AUTOMATIC_VOLUME_CONTROL_MAX_GAIN
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setAvcAmMaxGain(gain);
+    }
+
+    void setAmSoftMuteMaxAttenuation(uint8_t smattn)
+    {
+      if(shadowSkip(0x3302, smattn)) return;  // AM_SOFT_MUTE_MAX_ATTENUATION
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setAmSoftMuteMaxAttenuation(smattn);
+    }
+
+    void setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t BLETHC, uint8_t BLETHD)
+    {
+      uint32_t value = ((uint32_t)RDSEN << 16) | (BLETHA << 12) | (BLETHB << 8) | (BLETHC << 4) | BLETHD;
+      if(shadowSkip(0x1502, value)) return;  // FM_RDS_CONFIG
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setRdsConfig(RDSEN, BLETHA, BLETHB, BLETHC, BLETHD);
+    }
+
+    void setSeekFmLimits(uint16_t bottom, uint16_t top)
+    {
+      if(shadowSkip(0x1400, ((uint32_t)bottom << 16) | top)) return;  // FM_SEEK_BAND_BOTTOM/TOP
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekFmLimits(bottom, top);
+    }
+
+    void setSeekFmSpacing(uint16_t spacing)
+    {
+      if(shadowSkip(0x1402, spacing)) return;  // FM_SEEK_FREQ_SPACING
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekFmSpacing(spacing);
+    }
+
+    void setSeekFmSNRThreshold(uint16_t value)
+    {
+      if(shadowSkip(0x1403, value)) return;  // FM_SEEK_TUNE_SNR_THRESHOLD
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekFmSNRThreshold(value);
+    }
+
+    void setSeekFmRssiThreshold(uint16_t value)
+    {
+      if(shadowSkip(0x1404, value)) return;  // FM_SEEK_TUNE_RSSI_THRESHOLD
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekFmRssiThreshold(value);
+    }
+
+    void setSeekAmLimits(uint16_t bottom, uint16_t top)
+    {
+      if(shadowSkip(0x3400, ((uint32_t)bottom << 16) | top)) return;  // AM_SEEK_BAND_BOTTOM/TOP
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekAmLimits(bottom, top);
+    }
+
+    void setSeekAmSpacing(uint16_t spacing)
+    {
+      if(shadowSkip(0x3402, spacing)) return;  // AM_SEEK_FREQ_SPACING
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekAmSpacing(spacing);
+    }
+
+    void setSeekAmSNRThreshold(uint16_t value)
+    {
+      if(shadowSkip(0x3403, value)) return;  // AM_SEEK_SNR_THRESHOLD
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekAmSNRThreshold(value);
+    }
+
+    void setSeekAmRssiThreshold(uint16_t value)
+    {
+      if(shadowSkip(0x3404, value)) return;  // AM_SEEK_RSSI_THRESHOLD
+      PERF_I2C(0x12, 7, waitToSend());
+      SI4735::setSeekAmRssiThreshold(value);
+    }
+
+    // Shadowed commands
+    void setGpioCtl(uint8_t GPO1OEN, uint8_t GPO2OEN, uint8_t GPO3OEN)
+    {
+      if(shadowSkip(SHADOW_GPIO_CTL, (GPO1OEN << 2) | (GPO2OEN << 1) | GPO3OEN)) return;
+      PERF_I2C(0x80, 3, waitToSend());
+      SI4735::setGpioCtl(GPO1OEN, GPO2OEN, GPO3OEN);
+    }
+
+    void setGpio(uint8_t GPO1LEVEL, uint8_t GPO2LEVEL, uint8_t GPO3LEVEL)
+    {
+      if(shadowSkip(SHADOW_GPIO_SET, (GPO1LEVEL << 2) | (GPO2LEVEL << 1) | GPO3LEVEL)) return;
+      PERF_I2C(0x81, 3, waitToSend());
+      SI4735::setGpio(GPO1LEVEL, GPO2LEVEL, GPO3LEVEL);
+    }
+
+    // Traced commands (with ENABLE_PERF, sizes are bytes written and read)
+    void setFrequency(uint16_t freq)
+    {
+      PERF_I2C(isCurrentTuneFM()? 0x20 : 0x40, isCurrentTuneFM()? 6 : 7, waitToSend());  // FM/AM_TUNE_FREQ
+      SI4735::setFrequency(freq);
+    }
+
+    using SI4735::getStatus;
+    void getStatus(uint8_t INTACK, uint8_t CANCEL)
+    {
+      PERF_I2C(isCurrentTuneFM()? 0x22 : 0x42, 10, waitToSend());  // FM/AM_TUNE_STATUS
+      SI4735::getStatus(INTACK, CANCEL);
+    }
+
+    uint16_t getFrequency()
+    {
+      PERF_I2C(isCurrentTuneFM()? 0x22 : 0x42, 10, waitToSend());  // FM/AM_TUNE_STATUS
+      return(SI4735::getFrequency());
+    }
+
+    using SI4735::getCurrentReceivedSignalQuality;
+    void getCurrentReceivedSignalQuality()
+    {
+      PERF_I2C(isCurrentTuneFM()? 0x23 : 0x43, isCurrentTuneFM()? 10 : 8, waitToSend());  // FM/AM_RSQ_STATUS
+      SI4735::getCurrentReceivedSignalQuality();
+    }
+
+    using SI4735::getRdsStatus;
+    void getRdsStatus()
+    {
+      PERF_I2C(0x24, 15, waitToSend());  // FM_RDS_STATUS
+      SI4735::getRdsStatus();
+    }
+
+    void setSSBBfo(int offset)
+    {
+      PERF_I2C(0x12, 7, waitToSend());  // SET_PROPERTY SSB_BFO
+      SI4735::setSSBBfo(offset);
+    }
+
+    void setAutomaticGainControl(uint8_t AGCDIS, uint8_t AGCIDX)
+    {
+      PERF_I2C(isCurrentTuneFM()? 0x28 : 0x48, 4, waitToSend());  // FM/AM_AGC_OVERRIDE
+      SI4735::setAutomaticGainControl(AGCDIS, AGCIDX);
+    }
+
+    // Number of RDS groups waiting in the chip FIFO (reads status
+    // only, leaving the FIFO alone)
+    uint8_t getRdsFifoUsed()
+    {
+      PERF_I2C(0x24, 15, waitToSend());  // FM_RDS_STATUS
+      SI4735::getRdsStatus(0, 0, 1);
+      return(currentRdsStatus.resp.RDSFIFOUSED);
+    }
+
+    // Empty the chip RDS FIFO with a single status command
+    void clearRdsFifo()
+    {
+      PERF_I2C(0x24, 15, waitToSend());  // FM_RDS_STATUS
+      SI4735::getRdsStatus(0, 1, 1);
+    }
+
+    // True if the chip FIFO overflowed since the last group was read
+    bool getRdsGroupLost() { return(currentRdsStatus.resp.GRPLOST); }
+
+    // Take the oldest RDS group out of the chip FIFO, returning
+    // blocks A-D and their error levels (0 = no errors, 1 = 1-2,
+    // 2 = 3-5 errors corrected, 3 = uncorrectable)
+    void getRdsGroup(uint16_t *blocks, uint8_t *errors)
+    {
+      PERF_I2C(0x24, 15, waitToSend());  // FM_RDS_STATUS
+      SI4735::getRdsStatus(1, 0, 0);
+
+      blocks[0] = (currentRdsStatus.resp.BLOCKAH << 8) | currentRdsStatus.resp.BLOCKAL;
+      blocks[1] = (currentRdsStatus.resp.BLOCKBH << 8) | currentRdsStatus.resp.BLOCKBL;
+      blocks[2] = (currentRdsStatus.resp.BLOCKCH << 8) | currentRdsStatus.resp.BLOCKCL;
+      blocks[3] = (currentRdsStatus.resp.BLOCKDH << 8) | currentRdsStatus.resp.BLOCKDL;
+      errors[0] = currentRdsStatus.resp.BLEA;
+      errors[1] = currentRdsStatus.resp.BLEB;
+      errors[2] = currentRdsStatus.resp.BLEC;
+      errors[3] = currentRdsStatus.resp.BLED;
+    }
+
     // Fixing SI4735::getRdsPI() bug where it only returns BLOCKAL
     uint16_t getRdsPI(void)
     {
@@ -70,36 +415,78 @@ class SI4735_fixed: public SI4735
     } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (millis() - elapsed_seek) < maxSeekTime);
   }
 
-#if 0
-    // Speeding up SI4735::downloadPatch() function
+    // Speeding up SI4735::downloadPatch() function: each 8 byte
+    // chunk goes out in one write, followed by polling for CTS
+    // without fixed delays. Returns false if the chip reports an
+    // error or does not become ready.
     bool downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size)
     {
+      uint8_t chunk[8];
+
       for(uint16_t offset=0 ; offset<ssb_patch_content_size ; offset+=8)
       {
-        Wire.beginTransmission(deviceAddress);
-
-        for(uint16_t i=0 ; i<8 ; i++)
-          Wire.write(pgm_read_byte_near(ssb_patch_content + (i + offset)));
+        memcpy_P(chunk, ssb_patch_content + offset, 8);
 
-        Wire.endTransmission();
-        waitToSend();
+        Wire.beginTransmission(deviceAddress);
+        Wire.write(chunk, 8);
+        if(Wire.endTransmission()) return(false);
+        if(!patchWaitToSend()) return(false);
       }
 
-      delayMicroseconds(250);
-      return true;
+      return(true);
     }
 
-    // Using the new downloadPatch() function here
-    void loadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, uint8_t ssb_audiobw)
+    // Using the new downloadPatch() function here, returns false
+    // if the patch has not been loaded correctly
+    bool loadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, uint8_t ssb_audiobw = 1)
     {
-      queryLibraryId();                                                                                                       patchPowerUp();
-      delay(50);                                                                                                              downloadPatch(ssb_patch_content, ssb_patch_content_size);                                                               // Parameters                                                                                                           // AUDIOBW - SSB Audio bandwidth; 0 = 1.2kHz (default); 1=2.2kHz; 2=3kHz; 3=4kHz; 4=500Hz; 5=1kHz;
-      // SBCUTFLT SSB - side band cutoff filter for band passand low pass filter ( 0 or 1)                                    // AVC_DIVIDER  - set 0 for SSB mode; set 3 for SYNC mode.
+      uint32_t start = micros();
+
+      shadowInvalidate();
+      PERF_I2C(0x16, ssb_patch_content_size, waitToSend());  // PATCH_DATA
+
+      queryLibraryId();
+      patchPowerUp();
+      syncAM = false;
+      patchOk = patchWaitToSend() && downloadPatch(ssb_patch_content, ssb_patch_content_size);
+
+      // SBCUTFLT SSB - side band cutoff filter for band passand low pass filter ( 0 or 1)
       // AVCEN - SSB Automatic Volume Control (AVC) enable; 0=disable; 1=enable (default).
       // SMUTESEL - SSB Soft-mute Based on RSSI or SNR (0 or 1).
       // DSP_AFCDIS - DSP AFC Disable or enable; 0=SYNC MODE, AFC enable; 1=SSB MODE, AFC disable.
-      setSSBConfig(ssb_audiobw, 1, 0, 0, 0, 1);
-      delay(25);
+      if(patchOk)
+      {
+        setSSBConfig(ssb_audiobw, 1, 0, 0, 0, 1);
+        patchOk = patchWaitToSend();
+      }
+
+      patchTime = micros() - start;
+      patchResident = patchOk;
+      patchLoads++;
+      return(patchOk);
     }
-#endif
+
+    // Last SSB patch load time (us) and result
+    uint32_t getPatchTime() { return(patchTime); }
+    bool getPatchOk() { return(patchOk); }
+    uint32_t getPatchLoads() { return(patchLoads); }
+
+    // True if the SSB patch is loaded and the chip has not been
+    // powered up since
+    bool isPatchResident() { return(patchResident); }
+
+    // Demodulate AM with the SSB patch firmware in SYNC mode
+    // (DSP_AFCDIS=0, locked to the carrier, AVC divider 3), keeping
+    // the patch in the chip for the next switch to SSB. The caller
+    // sets the bandwidth.
+    void setSyncAM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq)
+    {
+      shadowInvalidate();
+      SI4735::setSSB(fromFreq, toFreq, initialFreq, 0, 2);
+      setSSBConfig(2, 0, 3, 1, 0, 0);
+      setSSBBfo(0);
+      syncAM = true;
+    }
+
+    bool isSyncAM() { return(syncAM); }
 };
@@ -1,15 +1,23 @@
 #include "Common.h"
 #include "Utils.h"
 #include "Menu.h"
-
-// Tuning delays after rx.setFrequency()
-#define TUNE_DELAY_DEFAULT 30
-#define TUNE_DELAY_FM      60
-#define TUNE_DELAY_AM_SSB  80
+#include "Perf.h"
+#include "Storage.h"
+#include "Rds.h"
 
 #define SCAN_POLL_TIME    10 // Tuning status polling interval (msecs)
 #define SCAN_POINTS      200 // Number of frequencies to scan
 
+#define MEMSCAN_RSSI      20 // Signal to stop at, if squelch is off (dBuV)
+#define MEMSCAN_HOLD    5000 // Time to stay on a signal (msecs)
+#define MEMSCAN_PROBE_FM  TUNE_DELAY_FM     // Time budget for an FM signal reading (msecs)
+#define MEMSCAN_PROBE_AM  TUNE_DELAY_AM_SSB // Time budget for an AM/SSB signal reading (msecs)
+
+#define PRIO_INTERVAL   5000 // Priority channel check interval (msecs)
+#define PRIO_RSSI         20 // Priority channel signal, if squelch is off (dBuV)
+#define PRIO_PROBE_FM     TUNE_DELAY_FM     // Time budget for an FM signal reading (msecs)
+#define PRIO_PROBE_AM     TUNE_DELAY_AM_SSB // Time budget for an AM/SSB signal reading (msecs)
+
 #define SCAN_OFF    0   // Scanner off, no data
 #define SCAN_RUN    1   // Scanner running
 #define SCAN_DONE   2   // Scanner done, valid data in scanData[]
@@ -31,6 +39,42 @@ static uint8_t  scanMaxRSSI;
 static uint8_t  scanMinSNR;
 static uint8_t  scanMaxSNR;
 
+// Memory scan visiting order and state
+static uint8_t  memScanOrder[MEMORY_COUNT];
+static uint8_t  memScanCount = 0;
+static uint8_t  memScanPos = 0;
+static int8_t   memScanDir = 0;        // Scan direction, 0 if off
+static bool     memScanMuted = false;  // Audio muted by the memory scan
+static uint32_t memScanHold = 0;       // Time stopped on a signal, 0 if scanning
+
+static struct
+{
+  uint32_t checked;                    // Channels checked
+  uint32_t time;                       // Time spent checking channels (msecs)
+  uint32_t switches;                   // Band or mode switches
+  uint32_t patches;                    // SSB patch loads
+  uint32_t stops;                      // Stops on a signal
+  uint32_t timeouts;                   // Channels not tuned within the budget
+} memScanStats;
+
+// Priority channel watch state
+static bool     prioOn = false;
+static uint16_t prioFreq;
+static int16_t  prioBFO;
+static uint8_t  prioBand;
+static uint8_t  prioMode;
+static uint32_t prioTime = 0;          // Time of the last check
+
+static struct
+{
+  uint32_t checks;                     // Priority channel checks
+  uint32_t switches;                   // Switches to the priority channel
+  uint32_t timeouts;                   // Probes not tuned within the budget
+  uint32_t total;                      // Total audio interruption (usecs)
+  uint32_t max;                        // Longest audio interruption (usecs)
+  uint32_t last;                       // Last audio interruption (usecs)
+} prioStats;
+
 static inline uint8_t min(uint8_t a, uint8_t b) { return(a<b? a:b); }
 static inline uint8_t max(uint8_t a, uint8_t b) { return(a>b? a:b); }
 
@@ -68,11 +112,11 @@ static void scanInit(uint16_t centerFreq, uint16_t step)
   const Band *band = getCurrentBand();
   int freq = scanStep * (centerFreq / scanStep - SCAN_POINTS / 2);
 
-  // Adjust to band boundaries
+  // Adjust to band boundaries, staying on the step grid
   if(freq + scanStep * (SCAN_POINTS - 1) > band->maximumFreq)
-    freq = band->maximumFreq - scanStep * (SCAN_POINTS - 1);
+    freq = band->maximumFreq / scanStep * scanStep - scanStep * (SCAN_POINTS - 1);
   if(freq < band->minimumFreq)
-    freq = band->minimumFreq;
+    freq = (band->minimumFreq + scanStep - 1) / scanStep * scanStep;
   scanStartFreq = freq;
 
   // Clear scan data
@@ -133,11 +177,53 @@ static bool scanTickTime()
   return(scanStatus==SCAN_RUN);
 }
 
+//
+// Wait for tuning to complete within the time budget (ms), then
+// measure the signal. Returns false if tuning takes longer.
+//
+static bool scanMeasure(uint32_t budget, uint8_t *rssi, uint8_t *snr)
+{
+  uint32_t start = millis();
+
+  do
+  {
+    rx.getStatus(0, 0);
+    if(rx.getTuneCompleteTriggered())
+    {
+      rx.getCurrentReceivedSignalQuality();
+      *rssi = rx.getCurrentRSSI();
+      *snr  = rx.getCurrentSNR();
+      return(true);
+    }
+
+    delay(1);
+  }
+  while(millis() - start < budget);
+
+  return(false);
+}
+
+//
+// Tune to the given frequency and measure the signal, polling for
+// tuning to complete within the time budget (ms). Returns false if
+// tuning takes longer. Does not mute or restore the frequency.
+//
+bool scanProbe(uint16_t freq, uint32_t budget, uint8_t *rssi, uint8_t *snr)
+{
+  rx.setMaxDelaySetFrequency(0);
+  rx.setFrequency(freq);
+  rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
+
+  return(scanMeasure(budget, rssi, snr));
+}
+
 //
 // Run entire scan once
 //
 void scanRun(uint16_t centerFreq, uint16_t step)
 {
+  PERF_LOOP(PERF_LOOP_SCAN);
+
   // Set tuning delay
   rx.setMaxDelaySetFrequency(currentMode == FM ? TUNE_DELAY_FM : TUNE_DELAY_AM_SSB);
   // Mute the audio
@@ -155,3 +241,304 @@ void scanRun(uint16_t centerFreq, uint16_t step)
   // Restore tuning delay
   rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
 }
+
+//
+// Memory scan visits FM, then AM, then SSB channels, so that
+// the SSB patch is loaded once per pass
+//
+static inline uint8_t memScanClass(uint8_t mode)
+{
+  return(mode==FM? 0 : mode==AM? 1 : 2);
+}
+
+static bool memScanBefore(const Memory *a, const Memory *b)
+{
+  if(memScanClass(a->mode) != memScanClass(b->mode))
+    return(memScanClass(a->mode) < memScanClass(b->mode));
+  if(a->band != b->band) return(a->band < b->band);
+  if(a->mode != b->mode) return(a->mode < b->mode);
+  return(a->freq < b->freq);
+}
+
+//
+// Compute memory scan visiting order, grouping occupied slots by
+// band and mode to keep band switches and patch loads down
+//
+static void memScanPlan()
+{
+  memScanCount = 0;
+
+  for(int i=0 ; i<MEMORY_COUNT ; i++)
+  {
+    const Memory *memory = &memories[i];
+    if(!memory->freq || memory->band>=getTotalBands()) continue;
+    if(!isMemoryInBand(&bands[memory->band], memory)) continue;
+
+    // Insertion sort, there are few slots
+    int j = memScanCount++;
+    for(; j>0 && memScanBefore(memory, &memories[memScanOrder[j-1]]) ; j--)
+      memScanOrder[j] = memScanOrder[j-1];
+    memScanOrder[j] = i;
+  }
+}
+
+//
+// Tune to a memory slot and measure the signal. Within the current
+// band and mode this is a plain frequency change, without the
+// usual tuning delay.
+//
+static bool memScanTune(const Memory *memory, uint8_t *rssi, uint8_t *snr)
+{
+  if(memory->band==bandIdx && memory->mode==currentMode)
+  {
+    rx.setMaxDelaySetFrequency(0);
+    updateFrequency(freqFromHz(memory->freq, memory->mode), false);
+    rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
+    if(bfoFromHz(memory->freq)) updateBFO(bfoFromHz(memory->freq));
+    clearStationInfo();
+
+    return(scanMeasure(currentMode==FM? MEMSCAN_PROBE_FM : MEMSCAN_PROBE_AM, rssi, snr));
+  }
+
+  // Band switch waits for tuning to complete
+  uint32_t patches = rx.getPatchLoads();
+  tuneToMemory(memory);
+  memScanStats.switches++;
+  memScanStats.patches += rx.getPatchLoads() - patches;
+
+  rx.getCurrentReceivedSignalQuality();
+  *rssi = rx.getCurrentRSSI();
+  *snr  = rx.getCurrentSNR();
+  return(true);
+}
+
+bool memScanOn()
+{
+  return(memScanDir != 0);
+}
+
+//
+// Start scanning occupied memory slots in the given direction,
+// returns false if there are none
+//
+bool memScanStart(int8_t dir)
+{
+  memScanPlan();
+  if(!memScanCount || !dir) return(false);
+
+  memScanDir  = dir>0? 1 : -1;
+  memScanPos  = dir>0? memScanCount - 1 : 0;
+  memScanHold = 0;
+
+  // Flag is set by rotary encoder and cleared on seek/scan entry
+  seekStop = false;
+
+  // Keep the amplifier off while switching channels, instead of
+  // muting and unmuting it on every band switch
+  if(!muteOn())
+  {
+    muteOn(1);
+    memScanMuted = true;
+  }
+
+  return(true);
+}
+
+void memScanStop()
+{
+  if(!memScanDir) return;
+
+  memScanDir = 0;
+  if(memScanMuted)
+  {
+    muteOn(0);
+    if(squelchCutoff) tempMuteOn(true);
+    memScanMuted = false;
+  }
+
+  prefsRequestSave(SAVE_ALL);
+}
+
+//
+// Tick memory scan time, checking the next channel or staying on
+// a signal for a while. Returns true if the display needs update.
+//
+bool memScanTickTime()
+{
+  if(!memScanDir) return(false);
+
+  // Turning the encoder stops the scan (seek mode handles
+  // its own encoder rotation)
+  if(seekStop && currentCmd!=CMD_SEEK)
+  {
+    memScanStop();
+    return(true);
+  }
+
+  // Stay on a signal for a while
+  if(memScanHold)
+  {
+    if(millis() - memScanHold < MEMSCAN_HOLD) return(false);
+    memScanHold = 0;
+    if(memScanMuted) muteOn(1);
+  }
+
+  PERF_I2C_OP(PERF_I2C_TUNE);
+  uint32_t start = millis();
+  uint8_t level = 0, quality = 0;
+
+  memScanPos = (memScanPos + memScanDir + memScanCount) % memScanCount;
+  memoryIdx  = memScanOrder[memScanPos];
+  bool valid = memScanTune(&memories[memoryIdx], &level, &quality);
+
+  memScanStats.checked++;
+  memScanStats.time += millis() - start;
+  if(!valid) memScanStats.timeouts++;
+
+  // Stop on signals above squelch level
+  uint8_t threshold = currentSquelch && currentSquelch<=127? currentSquelch : MEMSCAN_RSSI;
+  if(valid && level>=threshold)
+  {
+    memScanHold = millis();
+    memScanStats.stops++;
+    identifyFrequency(currentFrequency + currentBFO / 1000);
+    if(memScanMuted)
+    {
+      muteOn(0);
+      squelchCutoff = false;
+    }
+  }
+
+  return(true);
+}
+
+//
+// Get time left (ms) until the memory scan needs to run again
+//
+uint32_t memScanWaitTime(uint32_t now)
+{
+  if(!memScanDir) return(UINT32_MAX);
+  if(!memScanHold) return(0);
+  return(now - memScanHold < MEMSCAN_HOLD? MEMSCAN_HOLD - (now - memScanHold) : 0);
+}
+
+//
+// Print memory scan statistics to serial
+//
+void memScanPrintStats()
+{
+  uint32_t rate = memScanStats.time? memScanStats.checked * 10000 / memScanStats.time : 0;
+
+  Serial.printf("memscan %s checked=%lu time=%lums rate=%lu.%lu/s switches=%lu patches=%lu stops=%lu timeouts=%lu\r\n",
+    memScanDir? "on" : "off", memScanStats.checked, memScanStats.time, rate / 10, rate % 10,
+    memScanStats.switches, memScanStats.patches, memScanStats.stops, memScanStats.timeouts
+  );
+}
+
+bool prioWatchOn()
+{
+  return(prioOn);
+}
+
+//
+// Start watching the current frequency as the priority channel
+//
+void prioWatchStart()
+{
+  prioFreq = currentFrequency;
+  prioBFO  = currentBFO;
+  prioBand = bandIdx;
+  prioMode = currentMode;
+  prioTime = millis();
+  prioOn   = true;
+}
+
+void prioWatchStop()
+{
+  prioOn = false;
+}
+
+//
+// Tick priority watch time, periodically tuning to the priority
+// channel for a quick signal reading. Stays there if the channel is
+// active, otherwise returns to the current frequency. Returns true
+// if the frequency has changed.
+//
+bool prioWatchTickTime()
+{
+  if(!prioOn || millis() - prioTime < PRIO_INTERVAL) return(false);
+  prioTime = millis();
+
+  // Only check within the priority channel band and mode, without
+  // band switches, and not while listening to it already
+  if(bandIdx!=prioBand || currentMode!=prioMode || currentFrequency==prioFreq) return(false);
+  if(memScanOn() || muteOn()) return(false);
+
+  PERF_I2C_OP(PERF_I2C_TUNE);
+  uint32_t start = micros();
+  uint32_t budget = currentMode==FM? PRIO_PROBE_FM : PRIO_PROBE_AM;
+  uint8_t threshold = currentSquelch && currentSquelch<=127? currentSquelch : PRIO_RSSI;
+  uint8_t level = 0, quality = 0;
+  int16_t cal = getCurrentBand()->bandCal;
+
+  // Count chip writes done for this check
+  rx.shadowBegin();
+  tempMuteOn(true);
+
+  // In SSB the BFO is part of the tuning, measure with it applied
+  if(isSSB()) rx.setSSBBfo(-(prioBFO + cal));
+  bool tuned  = scanProbe(prioFreq, budget, &level, &quality);
+  bool active = tuned && level>=threshold;
+  if(!tuned) prioStats.timeouts++;
+
+  if(active)
+  {
+    // Chip is already tuned, make it the current frequency
+    rx.setMaxDelaySetFrequency(0);
+    updateFrequency(prioFreq, false);
+    rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
+    if(isSSB()) updateBFO(prioBFO);
+    clearStationInfo();
+    identifyFrequency(currentFrequency + currentBFO / 1000);
+    prefsRequestSave(SAVE_CUR_BAND);
+    prioStats.switches++;
+  }
+  else
+  {
+    // Return to the current frequency and BFO
+    if(!scanProbe(currentFrequency, budget, &level, &quality)) prioStats.timeouts++;
+    if(isSSB()) rx.setSSBBfo(-(currentBFO + cal));
+  }
+
+  // Drop RDS groups received from the priority channel
+  if(!active && currentMode==FM) rdsFlush();
+  if(!squelchCutoff) tempMuteOn(false);
+  rx.shadowEnd(SHADOW_WATCH);
+
+  prioStats.last   = micros() - start;
+  prioStats.max    = prioStats.last > prioStats.max? prioStats.last : prioStats.max;
+  prioStats.total += prioStats.last;
+  prioStats.checks++;
+
+  return(active);
+}
+
+//
+// Get time left (ms) until the next priority channel check
+//
+uint32_t prioWatchWaitTime(uint32_t now)
+{
+  if(!prioOn) return(UINT32_MAX);
+  return(now - prioTime < PRIO_INTERVAL? PRIO_INTERVAL - (now - prioTime) : 0);
+}
+
+//
+// Print priority watch statistics to serial
+//
+void prioWatchPrintStats()
+{
+  Serial.printf("watch %s freq=%u checks=%lu switches=%lu timeouts=%lu gap avg=%luus max=%luus last=%luus\r\n",
+    prioOn? "on" : "off", prioFreq, prioStats.checks, prioStats.switches, prioStats.timeouts,
+    prioStats.checks? prioStats.total / prioStats.checks : 0, prioStats.max, prioStats.last
+  );
+}
@@ -0,0 +1,206 @@
+#include "Common.h"
+#include "Utils.h"
+#include "Perf.h"
+#include "Signal.h"
+
+static SignalMetric signalMetrics[SIGNAL_COUNT];
+static bool signalFirst = true;         // Next sample seeds the filters
+static uint32_t signalTime = 0;         // Time of the last sample
+static uint32_t signalActive = 0;       // Time of the last tuning
+
+//
+// Integer square root
+//
+static uint32_t isqrt(uint32_t x)
+{
+  uint32_t r = 0;
+
+  for(uint32_t bit = 1UL << 30 ; bit ; bit >>= 2)
+  {
+    if(x >= r + bit)
+    {
+      x -= r + bit;
+      r = (r >> 1) + bit;
+    }
+    else
+      r >>= 1;
+  }
+
+  return(r);
+}
+
+static inline uint8_t signalRound(int32_t v)
+{
+  v = (v + 128) >> 8;
+  return(v<0? 0 : v>255? 255 : v);
+}
+
+//
+// Add a sample to a metric. The filter weight follows the time since
+// the previous sample, so the time constant stays the same whatever
+// the sampling interval is.
+//
+static void signalUpdate(SignalMetric *m, uint8_t value, uint32_t dt, uint32_t now)
+{
+  int32_t x = (int32_t)value << 8;
+
+  m->last = value;
+
+  if(signalFirst)
+  {
+    m->ema  = x;
+    m->var  = 0;
+    m->peak = value;
+    m->peakTime = now;
+    return;
+  }
+
+  // Weight in 8-bit fixed point: dt / (tau + dt)
+  if(dt > SIGNAL_TAU * 4) dt = SIGNAL_TAU * 4;
+  int32_t alpha = (dt << 8) / (SIGNAL_TAU + dt);
+  if(!alpha) alpha = 1;
+
+  int32_t d = x - m->ema;
+  m->ema += (alpha * d) >> 8;
+  m->var += (alpha * (((d >> 4) * (d >> 4)) - m->var)) >> 8;
+
+  // Hold the peak for a while, then drop to the current level
+  if(value >= m->peak)
+  {
+    m->peak = value;
+    m->peakTime = now;
+  }
+  else if(now - m->peakTime >= SIGNAL_PEAK_HOLD)
+  {
+    uint8_t level = signalRound(m->ema);
+    m->peak = value > level? value : level;
+    m->peakTime = now;
+  }
+}
+
+//
+// Forget the signal history, after tuning to a new frequency. When
+// keepShown is TRUE, the displayed RSSI and SNR stay until the first
+// sample at the new frequency replaces them.
+//
+void signalReset(bool keepShown)
+{
+  memset(signalMetrics, 0, sizeof(signalMetrics));
+  signalFirst = true;
+  if(!keepShown) rssi = snr = 0;
+  signalActivity();
+}
+
+//
+// Sample faster for a while, after user tuning
+//
+void signalActivity()
+{
+  signalActive = millis();
+}
+
+//
+// Get the current sampling interval (ms): fast while tuning or
+// waiting for the squelch to open, slow when idle
+//
+uint32_t signalGetInterval()
+{
+  uint32_t idle = millis() - signalActive;
+
+  if(squelchCutoff || idle < SIGNAL_TUNE_TIME) return(SIGNAL_FAST_TIME);
+  if(sleepOn() || idle >= SIGNAL_IDLE_AFTER) return(SIGNAL_IDLE_TIME);
+  return(SIGNAL_TIME);
+}
+
+bool signalDue(uint32_t now)
+{
+  return(now - signalTime >= signalGetInterval());
+}
+
+//
+// Get time left (ms) until the next sample is due
+//
+uint32_t signalWaitTime(uint32_t now)
+{
+  uint32_t interval = signalGetInterval();
+  return(now - signalTime < interval? interval - (now - signalTime) : 0);
+}
+
+//
+// Sample RSSI and SNR, apply squelch and update the displayed
+// values. Returns true if the display needs to be redrawn.
+//
+bool signalSample()
+{
+  PERF_TRACE(PERF_TRACE_RSSI);
+  PERF_I2C_OP(PERF_I2C_RSSI);
+
+  uint32_t now = millis();
+  uint32_t dt = now - signalTime;
+  bool needRedraw = false;
+
+  signalTime = now;
+
+  rx.getCurrentReceivedSignalQuality();
+  signalUpdate(&signalMetrics[SIGNAL_RSSI], rx.getCurrentRSSI(), dt, now);
+  signalUpdate(&signalMetrics[SIGNAL_SNR], rx.getCurrentSNR(), dt, now);
+  signalFirst = false;
+
+  // Apply squelch if the volume is not muted. Open on the first
+  // strong sample, close once the average drops too.
+  uint8_t newRSSI = signalMetrics[SIGNAL_RSSI].last;
+  if(currentSquelch && currentSquelch <= 127)
+  {
+    if(newRSSI >= currentSquelch && squelchCutoff)
+    {
+      tempMuteOn(false);
+      squelchCutoff = false;
+    }
+    else if(newRSSI < currentSquelch && signalGet(SIGNAL_RSSI) < currentSquelch && !squelchCutoff)
+    {
+      tempMuteOn(true);
+      squelchCutoff = true;
+    }
+  }
+  else if(squelchCutoff)
+  {
+    tempMuteOn(false);
+    squelchCutoff = false;
+  }
+
+  // Show filtered RSSI and SNR only if they have changed
+  if(signalGet(SIGNAL_RSSI) != rssi)
+  {
+    rssi = signalGet(SIGNAL_RSSI);
+    needRedraw = true;
+  }
+  if(signalGet(SIGNAL_SNR) != snr)
+  {
+    snr = signalGet(SIGNAL_SNR);
+    needRedraw = true;
+  }
+
+  return(needRedraw);
+}
+
+//
+// Get filtered metric value
+//
+uint8_t signalGet(uint8_t id)
+{
+  return(signalRound(signalMetrics[id].ema));
+}
+
+uint8_t signalGetPeak(uint8_t id)
+{
+  return(signalMetrics[id].peak);
+}
+
+//
+// Get metric standard deviation
+//
+uint8_t signalGetDeviation(uint8_t id)
+{
+  uint32_t dev = isqrt(signalMetrics[id].var) >> 4;
+  return(dev>255? 255 : dev);
+}
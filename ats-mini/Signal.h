@@ -0,0 +1,41 @@
+#ifndef SIGNAL_H
+#define SIGNAL_H
+
+#include <stdint.h>
+
+#define SIGNAL_FAST_TIME     50   // Sampling interval while tuning or squelched (ms)
+#define SIGNAL_TIME         200   // Normal sampling interval (ms)
+#define SIGNAL_IDLE_TIME    500   // Sampling interval when idle (ms)
+#define SIGNAL_TUNE_TIME   1500   // Fast sampling after tuning (ms)
+#define SIGNAL_IDLE_AFTER 30000   // Idle after no tuning for (ms)
+#define SIGNAL_TAU          400   // Filter time constant (ms)
+#define SIGNAL_PEAK_HOLD   2000   // Peak hold time (ms)
+
+#define SIGNAL_RSSI   0
+#define SIGNAL_SNR    1
+#define SIGNAL_COUNT  2
+
+//
+// Filtered metric, values in 24.8 fixed point
+//
+typedef struct
+{
+  int32_t  ema;               // Exponential moving average
+  int32_t  var;               // Exponential moving variance
+  uint8_t  last;              // Last sample
+  uint8_t  peak;              // Peak value, held for SIGNAL_PEAK_HOLD
+  uint32_t peakTime;          // Time the peak was seen
+} SignalMetric;
+
+void signalReset(bool keepShown = false);
+void signalActivity();
+bool signalDue(uint32_t now);
+uint32_t signalWaitTime(uint32_t now);
+bool signalSample();
+
+uint8_t signalGet(uint8_t id);
+uint8_t signalGetPeak(uint8_t id);
+uint8_t signalGetDeviation(uint8_t id);
+uint32_t signalGetInterval();
+
+#endif // SIGNAL_H
@@ -3,6 +3,8 @@
 #include "Utils.h"
 #include "Menu.h"
 #include "EIBI.h"
+#include "Rds.h"
+#include "Perf.h"
 
 // CB frequency range
 #define MIN_CB_FREQUENCY 26060
@@ -99,6 +101,7 @@ void clearStationInfo()
   bufRadioText[0]   = '\0'; // Multiline!
   bufRadioText[1]   = '\0';
   piCode = 0x0000;
+  rdsReset();
 }
 
 static bool showStationName(const char *stationName, bool isLong = false)
@@ -223,20 +226,31 @@ static bool showRdsTime(const char *rdsTime)
   return(false);
 }
 
-bool checkRds()
+//
+// Drain and decode all RDS groups received since the last check,
+// keeping the chip FIFO from overflowing. Decoded information is
+// only shown if requested (i.e. when the signal is good enough).
+//
+bool checkRds(bool show)
 {
+  PERF_TRACE(PERF_TRACE_RDS);
+  PERF_I2C_OP(PERF_I2C_RDS);
+
   bool needRedraw = false;
   uint8_t mode = getRDSMode();
 
-  rx.getRdsStatus();
-
-  if(rx.getRdsReceived() && rx.getRdsSync() && rx.getRdsSyncFound())
+  if(rdsPoll() && show)
   {
-    needRedraw |= (mode & RDS_PS) && showStationName(rx.getRdsStationName());
-    needRedraw |= (mode & RDS_RT) && showRadioText(rx.getRdsVersionCode()? rx.getRdsText2B() : rx.getRdsText2A());
-    needRedraw |= (mode & RDS_PI) && showRdsPiCode(rx.getRdsPI());
-    needRedraw |= (mode & RDS_CT) && showRdsTime(rx.getRdsTime());
-    needRedraw |= (mode & RDS_PT) && showRdsProgramType(rx.getRdsProgramTypeX(), !!(mode & RDS_RBDS));
+    const char *ptyn = rdsGetProgramTypeName();
+
+    needRedraw |= (mode & RDS_PS) && showStationName(rdsGetStationName());
+    needRedraw |= (mode & RDS_RT) && showRadioText(rdsGetRadioText());
+    needRedraw |= (mode & RDS_PI) && showRdsPiCode(rdsGetPiCode());
+    needRedraw |= (mode & RDS_CT) && showRdsTime(rdsGetTime());
+
+    // Prefer program type name sent by the station, if any
+    if(mode & RDS_PT)
+      needRedraw |= ptyn? showProgramInfo(ptyn) : showRdsProgramType(rdsGetProgramType(), !!(mode & RDS_RBDS));
   }
 
   // Return TRUE if any RDS information changes
@@ -331,6 +345,8 @@ static const char *findScheduleByFreq(uint16_t freq, bool periodic)
 
 bool identifyFrequency(uint16_t freq, bool periodic)
 {
+  PERF_TRACE(PERF_TRACE_SCHEDULE);
+
   const char *name;
   static uint16_t last_freq = 0;
   static bool name_found = false;
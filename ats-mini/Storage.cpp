@@ -2,6 +2,7 @@
 #include "Storage.h"
 #include "Themes.h"
 #include "Menu.h"
+#include "Perf.h"
 #include <LittleFS.h>
 #include "nvs_flash.h"
 
@@ -29,6 +30,8 @@ void prefsTickTime()
   // Save configuration if requested
   if(itIsTimeToSave && ((millis() - storeTime) >= STORE_TIME))
   {
+    PERF_TRACE(PERF_TRACE_PREFS);
+
     prefsSave(itIsTimeToSave);
     storeTime = millis();
     itIsTimeToSave = 0;
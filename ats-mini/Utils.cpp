@@ -4,6 +4,8 @@
 #include "Button.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Events.h"
+#include "Perf.h"
 
 // SSB patch for whole SSBRX initialization string
 #include "patch_init.h"
@@ -16,8 +18,9 @@ static bool muted = false;
 // Current sleep status, returned by sleepOn()
 static bool sleep_on = false;
 
-// Current SSB patch status
-static bool ssbLoaded = false;
+// Last SSB patch load
+static uint32_t ssbLoadClock = 0;   // Last patch load I2C clock (Hz)
+static uint32_t ssbLoadRetries = 0; // Loads retried at the safe clock
 
 // Time
 static bool clockHasBeenSet = false;
@@ -74,21 +77,55 @@ const char *getMACAddress()
 //
 void loadSSB(uint8_t bandwidth, bool draw)
 {
-  if(!ssbLoaded)
+  // The patch survives switching between SSB and AM bands and
+  // modes, but not switching to FM, which power cycles the chip
+  if(!rx.isPatchResident())
   {
+    PERF_I2C_OP(PERF_I2C_PATCH);
+
     if(draw) drawMessage("Loading SSB");
-    // You can try rx.setI2CFastModeCustom(700000); or greater value
-    rx.setI2CFastModeCustom(400000);
-    rx.loadPatch(ssb_patch_content, sizeof(ssb_patch_content), bandwidth);
+
+    // Load at the fast clock, falling back to the safe one on errors
+    ssbLoadClock = SSB_PATCH_CLOCK;
+    rx.setI2CFastModeCustom(ssbLoadClock);
+    if(!rx.loadPatch(ssb_patch_content, sizeof(ssb_patch_content), bandwidth))
+    {
+      ssbLoadClock = SSB_PATCH_SAFE_CLOCK;
+      rx.setI2CFastModeCustom(ssbLoadClock);
+      ssbLoadRetries++;
+      if(!rx.loadPatch(ssb_patch_content, sizeof(ssb_patch_content), bandwidth) && draw)
+        drawMessage("SSB load failed");
+    }
     rx.setI2CFastModeCustom(100000);
-    ssbLoaded = true;
   }
 }
 
+//
+// Print SSB patch load time, clock and result
+//
+void printSSBLoad()
+{
+  if(!ssbLoadClock) return;
+
+  Serial.printf("ssb patch time=%lums clock=%lukHz %s loads=%lu retries=%lu %s\r\n",
+    rx.getPatchTime() / 1000, ssbLoadClock / 1000,
+    rx.getPatchOk()? "ok" : "failed", rx.getPatchLoads(), ssbLoadRetries,
+    rx.isPatchResident()? "resident" : "unloaded"
+  );
+}
+
+//
+// Power cycle the chip back to the stock firmware, dropping the SSB
+// patch, for what the patch firmware cannot do. The caller sets the
+// current band up again.
+//
 void unloadSSB()
 {
-  // Just mark SSB patch as unloaded
-  ssbLoaded = false;
+  if(!rx.isPatchResident()) return;
+
+  rx.powerDown();
+  rx.setup(RESET_PIN, MW_BAND_TYPE);
+  rx.setVolume(volume);
 }
 
 //
@@ -146,6 +183,8 @@ void tempMuteOn(bool x)
 //
 bool sleepOn(int x)
 {
+  PERF_TRACE(PERF_TRACE_SLEEP);
+
   if((x==1) && !sleep_on)
   {
     sleep_on = true;
@@ -156,7 +195,7 @@ bool sleepOn(int x)
     tft.writecommand(ST7789_SLPIN);
 
     // Wait till the button is released to prevent immediate wakeup
-    while(pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW).isPressed)
+    while(pb1.update(buttonPressed()).isPressed)
       delay(100);
 
     if(sleepModeIdx == SLEEP_LIGHT)
@@ -183,7 +222,7 @@ bool sleepOn(int x)
         bool wasLongPressed = false;
         while(true)
         {
-          ButtonTracker::State pb1st = pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW, 0);
+          ButtonTracker::State pb1st = pb1.update(buttonPressed(), 0);
           wasLongPressed |= pb1st.isLongPressed;
           if(wasLongPressed || !pb1st.isPressed) break;
           delay(100);
@@ -196,6 +235,7 @@ bool sleepOn(int x)
       rtc_gpio_pulldown_dis((gpio_num_t)ENCODER_PUSH_BUTTON);
       rtc_gpio_deinit((gpio_num_t)ENCODER_PUSH_BUTTON);
       pinMode(ENCODER_PUSH_BUTTON, INPUT_PULLUP);
+      eventAttachButton();
       if(squelchCutoff) tempMuteOn(true);
       sleepOn(false);
       // Enable WiFi
@@ -212,7 +252,7 @@ bool sleepOn(int x)
     ledcWrite(PIN_LCD_BL, currentBrt);
     // Wait till the button is released to prevent the main loop clicks
     pb1.reset(); // Reset the button state (its timers could be stale due to CPU sleep)
-    while(pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW, 0).isPressed)
+    while(pb1.update(buttonPressed(), 0).isPressed)
       delay(100);
   }
 
@@ -6,6 +6,7 @@
 // SSB patch functions
 void loadSSB(uint8_t bandwidth, bool draw = true);
 void unloadSSB();
+void printSSBLoad();
 
 // Get firmware version
 const char *getVersion(bool shorter = false);
@@ -4,6 +4,10 @@
 #include "Storage.h"
 #include "Themes.h"
 #include "Menu.h"
+#include "Perf.h"
+#include "Capture.h"
+#include "RdsLog.h"
+#include "Radio.h"
 
 #include <WiFi.h>
 #include <Preferences.h>
@@ -31,6 +35,10 @@ const String jsonStatus()
     ssid = String(RECEIVER_NAME);
   }
 
+  // Radio state is owned by the main loop, use its snapshot
+  RadioStatus status;
+  radioGetStatus(&status);
+
   JsonDocument doc;
   JsonObject root = doc.to<JsonObject>();
 
@@ -38,55 +46,51 @@ const String jsonStatus()
   root["ssid"] = ssid;
   root["mac"] = getMACAddress();
   root["version"] = getVersion(true);
-  root["bandIdx"] = bandIdx;
-  root["freq"] = freqToHz(currentFrequency, currentMode) + currentBFO;
-  root["modeIdx"] = currentMode;
-  root["rssi"] = rssi;
-  root["snr"] = snr;
-  root["battery"] = batteryMonitor();
-  root["stepIdx"] = bands[bandIdx].currentStepIdx;
-  root["bandwidthIdx"] = bands[bandIdx].bandwidthIdx;
-  root["agc"] = !agcNdx && !agcIdx;
-  if (agcIdx)
-  {
-    root["attenuation"] = agcNdx;
+  root["bandIdx"] = status.bandIdx;
+  root["freq"] = status.freq;
+  root["modeIdx"] = status.modeIdx;
+  root["rssi"] = status.rssi;
+  root["snr"] = status.snr;
+  root["rssiPeak"] = status.rssiPeak;
+  root["snrPeak"] = status.snrPeak;
+  root["doneId"] = status.doneId;
+  root["failedId"] = status.failedId;
+  root["battery"] = batteryGetVolts();
+  root["stepIdx"] = status.stepIdx;
+  root["bandwidthIdx"] = status.bandwidthIdx;
+  root["agc"] = !status.agcNdx && !status.agcIdx;
+  if (status.agcIdx)
+  {
+    root["attenuation"] = status.agcNdx;
   }
   const char *time = clockGet();
   if (time)
   {
     root["time"] = time;
   }
-  root["volume"] = volume;
-  root["squelch"] = currentSquelch;
-  if(currentMode != FM)
-  {
-    root["softMuteMaxAttIdx"] = softMuteMaxAttIdx;
-  }
-  if(isSSB())
-  {
-    root["avc"] = SsbAvcIdx;
-  }
-  else if(currentMode != FM)
+  root["volume"] = status.volume;
+  root["squelch"] = status.squelch;
+  if(status.modeIdx != FM)
   {
-    root["avc"] = AmAvcIdx;
+    root["softMuteMaxAttIdx"] = status.softMuteMaxAttIdx;
+    root["avc"] = status.avc;
   }
 
-  if(currentMode == FM)
+  if(status.modeIdx == FM)
   {
     JsonObject rds = root["rds"].to<JsonObject>();
-    uint16_t piCode = getRdsPiCode();
-    if (piCode)
+    if (status.piCode)
     {
-      rds["piCode"] = String(piCode, HEX);
+      rds["piCode"] = String(status.piCode, HEX);
     }
-    String stationName = getStationName();
+    String stationName = status.stationName;
     if (stationName != "")
     {
       rds["stationName"] = stationName;
     }
 
     String radioText = "";
-    const char *rt = getRadioText();
+    const char *rt = status.radioText;
     for(; *rt; rt+=strlen(rt)+1) {
       radioText += String(rt) + " ";
     }
@@ -95,7 +99,7 @@ const String jsonStatus()
       rds["radioText"] = radioText;
     }
 
-    String programInfo = getProgramInfo();
+    String programInfo = status.programInfo;
     if (programInfo != "")
     {
       rds["programInfo"] = programInfo;
@@ -107,126 +111,44 @@ const String jsonStatus()
   return json;
 }
 
-void jsonSetStatus(JsonDocument request)
+uint32_t jsonSetStatus(JsonDocument request)
 {
-  uint32_t prefsSave = 0;
+  RadioBatch batch = {};
 
+  // Radio commands are executed by the main loop, in this order
   if(request["bandIdx"].is<int>())
-  {
-    const uint bandIdx = clamp_range(request["bandIdx"], 0, getTotalBands() - 1);
-    switchBand(bandIdx);
-
-    prefsSave |= SAVE_SETTINGS;
-    prefsSave |= SAVE_BANDS;
-  }
+    radioAdd(&batch, RADIO_CMD_BAND, request["bandIdx"]);
 
   if(request["freq"].is<int>())
-  {
-    const uint freqRead = request["freq"];
-    const uint16_t currentFrequencyRead = freqFromHz(freqRead, currentMode);
-    const int16_t currentBFORead = currentMode == FM ? 0 : bfoFromHz(freqRead);
-
-    updateFrequency(currentFrequencyRead, true);
-    if (isSSB())
-    {
-      updateBFO(currentBFORead, true);
-    }
-
-    // Clear current station name and information
-    clearStationInfo();
-    // Check for named frequencies
-    identifyFrequency(currentFrequency + currentBFO / 1000);
-
-    prefsSave |= SAVE_SETTINGS;
-    prefsSave |= SAVE_CUR_BAND;
-  }
+    radioAdd(&batch, RADIO_CMD_FREQ, request["freq"]);
 
   if(request["stepIdx"].is<int>())
-  {
-    const uint newStepIdx = clamp_range(request["stepIdx"], 0, getLastStep(currentMode));
-    switchStep(newStepIdx);
-
-    prefsSave |= SAVE_CUR_BAND;
-  }
+    radioAdd(&batch, RADIO_CMD_STEP, request["stepIdx"]);
 
   if(request["bandwidthIdx"].is<int>())
-  {
-    const uint newBdwIdx = clamp_range(request["bandwidthIdx"], 0, getLastBandwidth(currentMode));
-    switchBandwidth(newBdwIdx);
-
-    prefsSave |= SAVE_CUR_BAND;
-  }
+    radioAdd(&batch, RADIO_CMD_BANDWIDTH, request["bandwidthIdx"]);
 
-  bool setAttenuation = false;
-  if(request["agc"].is<bool>() && request["attenuation"].is<int>())
+  if(request["agc"].is<bool>() || request["attenuation"].is<int>())
   {
-    bool agc = request["agc"];
-    if (!agc)
-    {
-      int8_t attenuation = request["attenuation"];
-      int8_t newAgcIdx;
-      if(currentMode==FM)
-        newAgcIdx = clamp_range(attenuation, 0, 26);
-      else if(isSSB())
-        newAgcIdx = clamp_range(attenuation, 0, 0);
-      else
-        newAgcIdx = clamp_range(attenuation, 0, 36);
-
-      switchAgc(newAgcIdx + 1);
-      setAttenuation = true;
-    }
-  }
-  else if (request["agc"].is<bool>())
-  {
-    bool agc = request["agc"];
-    switchAgc(agc ? 0 : 1);
-    setAttenuation = true;
+    radioAdd(&batch, RADIO_CMD_AGC,
+      request["agc"].is<bool>()? request["agc"].as<bool>() : RADIO_UNSET,
+      request["attenuation"].is<int>()? request["attenuation"].as<int>() : RADIO_UNSET
+    );
   }
-  else if (request["attenuation"].is<int>())
-  {
-    int8_t attenuation = request["attenuation"];
-    int8_t newAgcIdx;
-    if(currentMode==FM)
-      newAgcIdx = clamp_range(attenuation, 0, 26);
-    else if(isSSB())
-      newAgcIdx = clamp_range(attenuation, 0, 0);
-    else
-      newAgcIdx = clamp_range(attenuation, 0, 36);
-
-    switchAgc(newAgcIdx + 1);
-    setAttenuation = true;
-  }
-  if (setAttenuation) prefsSave |= SAVE_SETTINGS;
 
   if(request["volume"].is<int>())
-  {
-    volume = clamp_range(request["volume"], 0, 63);
-    if(!muteOn()) rx.setVolume(volume);
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_VOLUME, request["volume"]);
 
   if(request["squelch"].is<int>())
-  {
-    currentSquelch = clamp_range(request["squelch"], 0, 127);
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_SQUELCH, request["squelch"]);
 
-  if(currentMode != FM && request["softMuteMaxAttIdx"].is<int>())
-  {
-    int8_t newSoftMute = clamp_range(request["softMuteMaxAttIdx"], 0, 32);
-    switchSoftMute(newSoftMute);
-    prefsSave |= SAVE_SETTINGS;
-  }
+  if(request["softMuteMaxAttIdx"].is<int>())
+    radioAdd(&batch, RADIO_CMD_SOFTMUTE, request["softMuteMaxAttIdx"]);
 
-  if(currentMode != FM && request["avc"].is<int>())
-  {
-    int8_t newAvc = clamp_range(request["avc"], 12, 90);
-    switchAvc(newAvc);
-    prefsSave |= SAVE_SETTINGS;
-  }
+  if(request["avc"].is<int>())
+    radioAdd(&batch, RADIO_CMD_AVC, request["avc"]);
 
-  // Save preferences immediately
-  prefsRequestSave(prefsSave, true);
+  return(radioPost(&batch));
 }
 
 const String jsonStatusOptions()
@@ -381,6 +303,9 @@ const String jsonMemoryOptions()
 
 const String jsonConfig()
 {
+  // Own preferences handle, the main loop uses the shared one
+  Preferences prefs;
+
   prefs.begin("network", true, STORAGE_PARTITION);
   String loginUsername = prefs.getString("loginusername", "");
   String loginPassword = prefs.getString("loginpassword", "");
@@ -419,9 +344,11 @@ const String jsonConfig()
   return json;
 }
 
-void jsonSetConfig(JsonDocument request)
+uint32_t jsonSetConfig(JsonDocument request)
 {
-  uint32_t prefsSave = 0;
+  // Own preferences handle, the main loop uses the shared one
+  Preferences prefs;
+  RadioBatch batch = {};
 
   // Start modifying prefs
   prefs.begin("network", false, STORAGE_PARTITION);
@@ -458,85 +385,43 @@ void jsonSetConfig(JsonDocument request)
   // Done with the prefs
   prefs.end();
 
+  // Settings are applied and saved by the main loop
   if(request["brightness"].is<int>())
-  {
-    currentBrt = request["brightness"];
-    if(!sleepOn()) ledcWrite(PIN_LCD_BL, currentBrt);
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_BRIGHTNESS, request["brightness"]);
 
   if(request["calibration"].is<int>())
-  {
-    getCurrentBand()->bandCal = request["calibration"];
-    if(isSSB()) updateBFO(currentBFO, true);
-    prefsSave |= SAVE_CUR_BAND;
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_CAL, request["calibration"]);
 
   if(request["rdsModeIdx"].is<int>())
-  {
-    rdsModeIdx = request["rdsModeIdx"];
-    if(!(getRDSMode() & RDS_CT)) clockReset();
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_RDSMODE, request["rdsModeIdx"]);
 
-  // Save time zone
   if(request["utcOffsetIdx"].is<int>())
-  {
-    utcOffsetIdx = request["utcOffsetIdx"];
-    clockRefreshTime();
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_UTCOFFSET, request["utcOffsetIdx"]);
 
   if(request["fmRegionIdx"].is<int>())
-  {
-    FmRegionIdx = request["fmRegionIdx"];
-    rx.setFMDeEmphasis(fmRegions[FmRegionIdx].value);
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_FMREGION, request["fmRegionIdx"]);
 
-  // Save theme
   if(request["themeIdx"].is<int>())
-  {
-    themeIdx = request["themeIdx"];
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_THEME, request["themeIdx"]);
 
   if(request["uiLayoutIdx"].is<int>())
-  {
-    uiLayoutIdx = request["uiLayoutIdx"];
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_UILAYOUT, request["uiLayoutIdx"]);
 
   if(request["zoomMenu"].is<bool>())
-  {
-    zoomMenu = request["zoomMenu"];
-    prefsSave |= SAVE_SETTINGS;
-  }
+    radioAdd(&batch, RADIO_CMD_ZOOMMENU, request["zoomMenu"].as<bool>());
 
   if(request["scrollDirection"].is<signed int>())
-  {
-    const unsigned int scrollDir = request["scrollDirection"].as<signed int>();
-    if (scrollDir == -1 || scrollDir == 1)
-    {
-      scrollDirection = scrollDir;
-      prefsSave |= SAVE_SETTINGS;
-    }
-  }
+    radioAdd(&batch, RADIO_CMD_SCROLLDIR, request["scrollDirection"].as<signed int>());
 
   if(request["sleepModeIdx"].is<int>())
-  {
-    sleepModeIdx = request["sleepModeIdx"];
-    prefsSave |= SAVE_SETTINGS;
-  }
-
-  // Save preferences immediately
-  prefsRequestSave(prefsSave, true);
+    radioAdd(&batch, RADIO_CMD_SLEEPMODE, request["sleepModeIdx"]);
 
   // If we are currently in AP mode, and infrastructure mode requested,
   // and there is at least one SSID / PASS pair, request network connection
   if(haveSSID && (wifiModeIdx > NET_AP_ONLY) && (WiFi.status() != WL_CONNECTED))
     netRequestConnect();
+
+  return(radioPost(&batch));
 }
 
 const String jsonConfigOptions()
@@ -600,8 +485,140 @@ const String jsonConfigOptions()
   return json;
 }
 
+#ifdef ENABLE_PERF
+const String jsonPerfRender()
+{
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+
+  root["cpuFreq"] = ESP.getCpuFreqMHz();
+
+  JsonArray probesArray = root["probes"].to<JsonArray>();
+  for(uint8_t i=0; i<PERF_DRAW_COUNT; i++)
+  {
+    PerfStats stats;
+    if(!perfRenderStats(i, &stats)) continue;
+
+    JsonObject probeObj = probesArray.add<JsonObject>();
+    probeObj["name"] = perfRenderName(i);
+    probeObj["count"] = stats.count;
+    probeObj["min"] = stats.min;
+    probeObj["avg"] = stats.avg;
+    probeObj["p99"] = stats.p99;
+  }
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+const String jsonPerfTrace()
+{
+  PerfTraceEvent *events = (PerfTraceEvent *)malloc(PERF_TRACE_SIZE * sizeof(PerfTraceEvent));
+  uint32_t duration = 0;
+  size_t n = events? perfTraceSnapshot(events, &duration) : 0;
+
+  // Chrome trace event format
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+
+  root["displayTimeUnit"] = "ms";
+  root["otherData"]["stall"] = duration;
+
+  JsonArray eventsArray = root["traceEvents"].to<JsonArray>();
+  for(size_t i=0; i<n; i++)
+  {
+    JsonObject eventObj = eventsArray.add<JsonObject>();
+    eventObj["name"] = perfTraceName(events[i].id);
+    eventObj["ph"] = String(events[i].phase);
+    eventObj["ts"] = events[i].time;
+    eventObj["pid"] = 1;
+    eventObj["tid"] = 1;
+  }
+
+  free(events);
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+const String jsonPerfI2c()
+{
+  PerfI2cEvent *events = (PerfI2cEvent *)malloc(PERF_I2C_SIZE * sizeof(PerfI2cEvent));
+  size_t n = events? perfI2cSnapshot(events) : 0;
+
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+
+  JsonArray opsArray = root["operations"].to<JsonArray>();
+  for(uint8_t i=0; i<PERF_I2C_COUNT; i++)
+  {
+    PerfI2cStats st;
+    if(!perfI2cStats(i, &st)) continue;
+
+    JsonObject opObj = opsArray.add<JsonObject>();
+    opObj["name"] = perfI2cName(i);
+    opObj["count"] = st.count;
+    opObj["bytes"] = st.bytes;
+    opObj["avg"] = st.count? (uint32_t)(st.total / st.count) : 0;
+    opObj["cts"] = st.count? (uint32_t)(st.cts / st.count) : 0;
+    opObj["max"] = st.max;
+  }
+
+  JsonArray eventsArray = root["recent"].to<JsonArray>();
+  for(size_t i=0; i<n; i++)
+  {
+    JsonObject eventObj = eventsArray.add<JsonObject>();
+    eventObj["op"] = perfI2cName(events[i].op);
+    eventObj["opcode"] = events[i].opcode;
+    eventObj["bytes"] = events[i].bytes;
+    eventObj["time"] = events[i].time;
+    eventObj["duration"] = events[i].duration;
+    eventObj["cts"] = events[i].cts;
+  }
+
+  free(events);
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+const String jsonPerfLoop()
+{
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+
+  root["cpuFreq"] = ESP.getCpuFreqMHz();
+
+  JsonArray phasesArray = root["phases"].to<JsonArray>();
+  for(uint8_t i=0; i<PERF_LOOP_COUNT; i++)
+  {
+    const PerfHistogram *h = perfLoopHistogram(i);
+
+    JsonObject phaseObj = phasesArray.add<JsonObject>();
+    phaseObj["name"] = perfLoopName(i);
+    phaseObj["count"] = h->count;
+    phaseObj["avg"] = h->count? (uint32_t)(h->total / h->count) : 0;
+    phaseObj["max"] = h->max;
+
+    // Bucket i counts samples shorter than 2^i us (the last one is open)
+    JsonArray bucketsArray = phaseObj["histogram"].to<JsonArray>();
+    for(uint8_t j=0; j<PERF_BUCKETS; j++)
+      bucketsArray.add(h->buckets[j]);
+  }
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+#endif
+
 bool checkApiAuth(AsyncWebServerRequest *request)
 {
+  Preferences prefs;
+
   prefs.begin("network", true, STORAGE_PARTITION);
   String loginUsername = prefs.getString("loginusername", "");
   String loginPassword = prefs.getString("loginpassword", "");
@@ -621,6 +638,18 @@ void sendJsonResponse(AsyncWebServerRequest *request, int code, String content)
   request->send(response);
 }
 
+//
+// Response to requests executed later by the main loop, with the
+// id that shows up in the status once the request is done
+//
+static void sendAccepted(AsyncWebServerRequest *request, uint32_t id)
+{
+  if(!id)
+    sendJsonResponse(request, 503, "{\"error\":\"Too many pending requests\"}");
+  else
+    sendJsonResponse(request, 202, "{\"id\":" + String(id) + "}");
+}
+
 void addApiListeners(AsyncWebServer& server)
 {
   server.on("/api/status", HTTP_GET, [] (AsyncWebServerRequest *request) {
@@ -638,9 +667,7 @@ void addApiListeners(AsyncWebServer& server)
         sendJsonResponse(request, 400, "{\"error\":\"Invalid JSON\"}");
         return;
       }
-      jsonSetStatus(jsonRequest);
-
-      sendJsonResponse(request, 200, jsonStatus());
+      sendAccepted(request, jsonSetStatus(jsonRequest));
   });
 
   server.on("/api/statusOptions", HTTP_GET, [] (AsyncWebServerRequest *request) {
@@ -680,11 +707,14 @@ void addApiListeners(AsyncWebServer& server)
           return;
         }
 
+        RadioStatus status;
+        radioGetStatus(&status);
+
         Memory newMemory;
-        newMemory.freq  = freqToHz(currentFrequency, currentMode) + currentBFO;
-        newMemory.mode  = currentMode;
-        newMemory.band  = bandIdx;
-        sprintf(newMemory.name, "%.9s", getStationName());
+        newMemory.freq  = status.freq;
+        newMemory.mode  = status.modeIdx;
+        newMemory.band  = status.bandIdx;
+        sprintf(newMemory.name, "%.9s", status.stationName);
         memories[memoryIdx] = newMemory;
 
         prefsRequestSave(SAVE_MEMORIES, true);
@@ -714,19 +744,11 @@ void addApiListeners(AsyncWebServer& server)
           return;
         }
 
-        const bool res = tuneToMemory(memory);
-        if (res)
-        {
-          // If tuning was successful, return the current status
-          sendJsonResponse(request, 200, "");
-          return;
-        }
-        else
-        {
-          // If tuning failed, return an error
-          sendJsonResponse(request, 500, "{\"error\":\"Failed tuning to memory\"}");
-          return;
-        }
+        // Tuning failures are reported with the status
+        RadioBatch batch = {};
+        radioAdd(&batch, RADIO_CMD_MEMORY, memoryIdx);
+        sendAccepted(request, radioPost(&batch));
+        return;
       }
 
       // Check if this is a memory removal request
@@ -823,15 +845,90 @@ void addApiListeners(AsyncWebServer& server)
         sendJsonResponse(request, 400, "{\"error\":\"Invalid JSON\"}");
         return;
       }
-      jsonSetConfig(jsonRequest);
-
-      sendJsonResponse(request, 200, jsonConfig());
+      sendAccepted(request, jsonSetConfig(jsonRequest));
   });
 
   server.on("/api/configOptions", HTTP_GET, [] (AsyncWebServerRequest *request) {
     sendJsonResponse(request, 200, jsonConfigOptions());
   });
 
+  server.on("/api/screenshot.bmp", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    // One download at a time, with the snapshot taken by the main loop
+    uint32_t id = captureBmpRequest();
+    RadioBatch batch = {};
+    radioAdd(&batch, RADIO_CMD_SCREENSHOT);
+
+    if(!id || !radioPost(&batch))
+    {
+      if(id) captureBmpRelease(id);
+      sendJsonResponse(request, 503, "{\"error\":\"Screenshot busy, try again later\"}");
+      return;
+    }
+
+    request->onDisconnect([id] () { captureBmpRelease(id); });
+
+    // Stream image in chunks, as the network buffers allow
+    AsyncWebServerResponse *response = request->beginResponse("image/bmp", captureBmpSize(),
+      [id] (uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        return captureBmpRead(id, buffer, maxLen, index);
+      });
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(response);
+  });
+
+  server.on("/api/rds/capture.bin", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    RdsLogHeader snap;
+    size_t size = rdsLogSnapshot(&snap, false);
+    if(!size)
+    {
+      sendJsonResponse(request, 404, "{\"error\":\"No RDS capture\"}");
+      return;
+    }
+
+    AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", size,
+      [snap] (uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        return rdsLogRead(&snap, buffer, maxLen, index, false);
+      });
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(response);
+  });
+
+  server.on("/api/rds/capture.spy", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    RdsLogHeader snap;
+    size_t size = rdsLogSnapshot(&snap, true);
+    if(!size)
+    {
+      sendJsonResponse(request, 404, "{\"error\":\"No RDS capture\"}");
+      return;
+    }
+
+    AsyncWebServerResponse *response = request->beginResponse("text/plain", size,
+      [snap] (uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        return rdsLogRead(&snap, buffer, maxLen, index, true);
+      });
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(response);
+  });
+
+#ifdef ENABLE_PERF
+  server.on("/api/perf/render", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    sendJsonResponse(request, 200, jsonPerfRender());
+  });
+
+  server.on("/api/perf/i2c", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    sendJsonResponse(request, 200, jsonPerfI2c());
+  });
+
+  server.on("/api/trace", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    sendJsonResponse(request, 200, jsonPerfTrace());
+  });
+
+  // Must follow more specific /api/perf/... routes
+  server.on("/api/perf", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    sendJsonResponse(request, 200, jsonPerfLoop());
+  });
+#endif
+
   server.on("/api", HTTP_OPTIONS, [] (AsyncWebServerRequest *request) {
     String allowedMethods = "GET, OPTIONS";
 
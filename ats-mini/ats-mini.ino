@@ -5,6 +5,7 @@
 #include "Common.h"
 #include <Wire.h>
 #include "Rotary.h"
+#include "Encoder.h"
 #include "Button.h"
 #include "Menu.h"
 #include "Draw.h"
@@ -12,10 +13,16 @@
 #include "Themes.h"
 #include "Utils.h"
 #include "EIBI.h"
+#include "Capture.h"
+#include "Events.h"
+#include "Radio.h"
+#include "Rds.h"
+#include "RdsLog.h"
+#include "Signal.h"
+#include "Perf.h"
 
 // SI473/5 and UI
 #define MIN_ELAPSED_TIME         5  // 300
-#define MIN_ELAPSED_RSSI_TIME  200  // RSSI check uses IN_ELAPSED_RSSI_TIME * 6 = 1.2s
 #define ELAPSED_COMMAND      10000  // time to turn off the last command controlled by encoder. Time to goes back to the VFO control // G8PTN: Increased time and corrected comment
 #define DEFAULT_VOLUME          35  // change it for your favorite sound volume
 #define DEFAULT_SLEEP            0  // Default sleep interval, range = 0 (off) to 255 in steps of 5
@@ -24,8 +31,6 @@
 #define SEEK_TIMEOUT        600000  // Max seek timeout (ms)
 #define NTP_CHECK_TIME       60000  // NTP time refresh period (ms)
 #define SCHEDULE_CHECK_TIME   2000  // How often to identify the same frequency (ms)
-#define BACKGROUND_REFRESH_TIME 5000    // Background screen refresh time. Covers the situation where there are no other events causing a refresh
-#define TUNE_HOLDOFF_TIME       90  // Timer to hold off display whilst tuning
 
 // =================================
 // CONSTANTS AND VARIABLES
@@ -39,7 +44,6 @@ int8_t softMuteMaxAttIdx = 4;
 bool seekStop = false;        // G8PTN: Added flag to abort seeking on rotary encoder detection
 bool pushAndRotate = false;   // Push and rotate is active, ignore the long press
 
-long elapsedRSSI = millis();
 long elapsedButton = millis();
 
 long lastStrengthCheck = millis();
@@ -48,7 +52,8 @@ long lastNTPCheck = millis();
 long lastScheduleCheck = millis();
 
 long elapsedCommand = millis();
-volatile int encoderCount = 0;
+int encoderCount = 0;
+bool encoderFast = false;
 uint16_t currentFrequency;
 
 // AGC/ATTN index per mode (FM/AM/SSB)
@@ -76,11 +81,6 @@ long elapsedSleep = millis();           // Display sleep timer
 bool zoomMenu = false;                  // Display zoomed menu item
 int8_t scrollDirection = 1;             // Menu scroll direction
 
-// Background screen refresh
-uint32_t background_timer = millis();   // Background screen refresh timer.
-uint32_t tuning_timer = millis();       // Tuning hold off timer.
-bool tuning_flag = false;               // Flag to indicate tuning
-
 //
 // Current parameters
 //
@@ -152,7 +152,7 @@ void setup()
 
   // Press and hold Encoder button to force an preferences reset
   // Note: preferences reset is recommended after firmware updates
-  if(digitalRead(ENCODER_PUSH_BUTTON)==LOW)
+  if(buttonPressed())
   {
     nvsErase();
     diskInit(true);
@@ -164,7 +164,7 @@ void setup()
     tft.println();
     tft.setTextColor(TH.text_warn, TH.bg);
     tft.print("Resetting Preferences");
-    while(digitalRead(ENCODER_PUSH_BUTTON) == LOW) delay(100);
+    while(buttonPressed()) delay(100);
   }
 
   // Initialize flash file system
@@ -204,8 +204,8 @@ void setup()
     ledcWrite(PIN_LCD_BL, currentBrt);
     drawAboutHelp(0);
     // Wait for an encoder click
-    while(digitalRead(ENCODER_PUSH_BUTTON)!=LOW) delay(100);
-    while(digitalRead(ENCODER_PUSH_BUTTON)==LOW) delay(100);
+    while(!buttonPressed()) delay(100);
+    while(buttonPressed()) delay(100);
   }
 
   // If loading memories fails, save default memories
@@ -225,15 +225,20 @@ void setup()
   rx.setMaxSeekTime(SEEK_TIMEOUT);
 
   // Draw display for the first time
+  batteryMonitor();
   drawScreen();
   ledcWrite(PIN_LCD_BL, currentBrt);
 
   // Interrupt actions for Rotary encoder
   // Note: Moved to end of setup to avoid inital interrupt actions
   // ICACHE_RAM_ATTR void rotaryEncoder(); see rotaryEncoder implementation below.
+  eventInit();
   attachInterrupt(digitalPinToInterrupt(ENCODER_PIN_A), rotaryEncoder, CHANGE);
   attachInterrupt(digitalPinToInterrupt(ENCODER_PIN_B), rotaryEncoder, CHANGE);
 
+  // Accept radio commands from other tasks
+  radioInit();
+
   // Connect WiFi, if necessary
   netInit(wifiModeIdx);
 
@@ -254,8 +259,9 @@ ICACHE_RAM_ATTR void rotaryEncoder()
   uint8_t encoderStatus = encoder.process();
   if(encoderStatus)
   {
-    encoderCount = encoderStatus==DIR_CW? 1 : -1;
+    encoderQueue(millis(), encoderStatus==DIR_CW? 1 : -1);
     seekStop = true;
+    eventPostFromISR(EVENT_ENCODER);
   }
 }
 
@@ -264,6 +270,15 @@ ICACHE_RAM_ATTR void rotaryEncoder()
 //
 void useBand(const Band *band)
 {
+  PERF_I2C_OP(PERF_I2C_BAND);
+
+  // Count chip writes done for this band switch
+  rx.shadowBegin();
+
+  // Poll for tuning to complete below, instead of waiting
+  // a fixed delay after each frequency change
+  rx.setMaxDelaySetFrequency(0);
+
   // Set current frequency and mode, reset BFO
   currentFrequency = band->currentFreq;
   currentMode = band->bandMode;
@@ -282,15 +297,21 @@ void useBand(const Band *band)
     rx.setSeekFmSNRThreshold(2); // default is 3
 
     rx.setFMDeEmphasis(fmRegions[FmRegionIdx].value);
-    rx.RdsInit();
     rx.setRdsConfig(1, 2, 2, 2, 2);
+    rdsInit();
     rx.setGpioCtl(1, 0, 0);   // G8PTN: Enable GPIO1 as output
     rx.setGpio(0, 0, 0);      // G8PTN: Set GPIO1 = 0
   }
   else
   {
     // rx.setMaxDelaySetFrequency(80);
-    if(band->bandMode==AM)
+    if(band->bandMode==AM && rx.isPatchResident())
+    {
+      // Keep the SSB patch loaded, demodulating AM in SYNC mode,
+      // so that switching back to SSB does not load it again
+      rx.setSyncAM(band->minimumFreq, band->maximumFreq, band->currentFreq);
+    }
+    else if(band->bandMode==AM)
     {
       rx.setAM(band->minimumFreq, band->maximumFreq, band->currentFreq, getCurrentStep()->step);
       // More sensitive seek thresholds
@@ -329,11 +350,19 @@ void useBand(const Band *band)
   doAgc(0);
   // Set currentAVC values based on mode (AM, SSB)
   doAvc(0);
-  // Wait a bit for things to calm down
-  delay(100);
+  rx.shadowEnd(SHADOW_BAND);
+
+  // Wait for things to calm down
+  for(uint32_t start = millis() ; millis() - start < TUNE_TIMEOUT ; delay(1))
+  {
+    rx.getStatus(0, 0);
+    if(rx.getTuneCompleteTriggered()) break;
+  }
+
+  rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
+
   // Clear signal strength readings
-  rssi = 0;
-  snr  = 0;
+  signalReset();
 }
 
 // This function is called by the seek function process.
@@ -344,10 +373,10 @@ bool checkStopSeeking()
 
   // Checking isPressed without debouncing because this callback
   // is not invoked often enough to register a click
-  if(pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW, 0).isPressed)
+  if(pb1.update(buttonPressed(), 0).isPressed)
   {
     // Wait till the button is released, otherwise the main loop will register a click
-    while(pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW).isPressed)
+    while(pb1.update(buttonPressed()).isPressed)
       delay(100);
     return true;
   }
@@ -447,6 +476,10 @@ bool updateFrequency(int newFreq, bool wrap)
   // Update current frequency
   currentFrequency = rx.getFrequency();
 
+  // Signal history belongs to the old frequency, keep showing the
+  // old values (and gating RDS with them) until the next sample
+  signalReset(true);
+
   // Save current band frequency
   band->currentFreq = currentFrequency + currentBFO / 1000;
   return true;
@@ -458,25 +491,38 @@ bool updateFrequency(int newFreq, bool wrap)
 //
 bool doSeek(int8_t dir)
 {
+  PERF_TRACE(PERF_TRACE_SEEK);
+  PERF_LOOP(PERF_LOOP_SEEK);
+
+  // Memory scan runs from the main loop, rotation starts or stops it
+  if(seekMode() == SEEK_MEMORY)
+  {
+    if(memScanOn()) memScanStop(); else memScanStart(dir);
+    return(true);
+  }
+
   // disable amp to avoid sound artifacts
   tempMuteOn(true);
   if(seekMode() == SEEK_DEFAULT)
   {
     if(isSSB())
     {
-#ifdef ENABLE_HOLDOFF
-      // Tuning timer to hold off (FM/AM) display updates
-      tuning_flag = true;
-      tuning_timer = millis();
-#endif
-
       updateBFO(currentBFO + dir * getCurrentStep(true)->step, true);
     }
     else
     {
+      // The SSB patch firmware cannot seek, go back to the stock
+      // firmware when it is demodulating AM
+      if(rx.isSyncAM())
+      {
+        unloadSSB();
+        selectBand(bandIdx, false);
+        tempMuteOn(true);
+      }
+
       // Clear stale parameters
       clearStationInfo();
-      rssi = snr = 0;
+      signalReset();
 
       // Flag is set by rotary encoder and cleared on seek/scan entry
       seekStop = false;
@@ -513,22 +559,24 @@ bool doSeek(int8_t dir)
 //
 bool doTune(int8_t dir, bool fast = false)
 {
+  PERF_I2C_OP(PERF_I2C_TUNE);
+
+  // Count chip writes done for this tuning step
+  rx.shadowBegin();
+
+  // Sample the signal faster while tuning
+  signalActivity();
+
   //
   // SSB tuning
   //
   if(isSSB())
   {
-#ifdef ENABLE_HOLDOFF
-    // Tuning timer to hold off (SSB) display updates
-    tuning_flag = true;
-    tuning_timer = millis();
-#endif
-
-    uint32_t step = getCurrentStep(fast)->step;
-    uint32_t stepAdjust = (currentFrequency * 1000 + currentBFO) % step;
-    step = !stepAdjust? step : dir>0? step - stepAdjust : stepAdjust;
+    int32_t step = getCurrentStep(fast)->step;
+    int32_t stepAdjust = (currentFrequency * 1000 + currentBFO) % step;
 
-    updateBFO(currentBFO + dir * step, true);
+    // First step snaps to the step grid, the rest are full steps
+    updateBFO(currentBFO + stepOffset(dir, step, stepAdjust), true);
   }
 
   //
@@ -536,25 +584,19 @@ bool doTune(int8_t dir, bool fast = false)
   //
   else
   {
-#ifdef ENABLE_HOLDOFF
-    // Tuning timer to hold off (FM/AM) display updates
-    tuning_flag = true;
-    tuning_timer = millis();
-#endif
-
-    uint16_t step = getCurrentStep(fast)->step;
-    uint16_t stepAdjust = currentFrequency % step;
+    int32_t step = getCurrentStep(fast)->step;
+    int32_t stepAdjust = currentFrequency % step;
     stepAdjust = (currentMode==FM) && (step==20)? (stepAdjust+10) % step : stepAdjust;
-    step = !stepAdjust? step : dir>0? step - stepAdjust : stepAdjust;
 
     // Tune to a new frequency
-    updateFrequency(currentFrequency + step * dir, true);
+    updateFrequency(currentFrequency + stepOffset(dir, step, stepAdjust), true);
   }
 
   // Clear current station name and information
   clearStationInfo();
   // Check for named frequencies
   identifyFrequency(currentFrequency + currentBFO / 1000);
+  rx.shadowEnd(SHADOW_TUNE);
   // Will need a redraw
   return(true);
 }
@@ -569,12 +611,6 @@ bool doDigit(int8_t dir)
   // SSB tuning
   if(isSSB())
   {
-#ifdef ENABLE_HOLDOFF
-    // Tuning timer to hold off (SSB) display updates
-    tuning_flag = true;
-    tuning_timer = millis();
-#endif
-
     updated = updateBFO(currentBFO + dir * getFreqInputStep(), false);
   }
 
@@ -583,12 +619,6 @@ bool doDigit(int8_t dir)
   //
   else
   {
-#ifdef ENABLE_HOLDOFF
-    // Tuning timer to hold off (FM/AM) display updates
-    tuning_flag = true;
-    tuning_timer = millis();
-#endif
-
     // Tune to a new frequency
     updated = updateFrequency(currentFrequency + getFreqInputStep() * dir, false);
   }
@@ -629,52 +659,13 @@ bool clickFreq(bool shortPress)
   return false;
 }
 
-bool processRssiSnr()
+//
+// Get time left (ms) until a periodic task is due, limited by wait
+//
+static uint32_t waitTime(uint32_t wait, uint32_t now, uint32_t last, uint32_t period)
 {
-  static uint32_t updateCounter = 0;
-  bool needRedraw = false;
-
-  rx.getCurrentReceivedSignalQuality();
-  int newRSSI = rx.getCurrentRSSI();
-  int newSNR = rx.getCurrentSNR();
-
-  // Apply squelch if the volume is not muted
-  if(currentSquelch && currentSquelch <= 127)
-  {
-    if(newRSSI >= currentSquelch && squelchCutoff)
-    {
-      tempMuteOn(false);
-      squelchCutoff = false;
-    }
-    else if(newRSSI < currentSquelch && !squelchCutoff)
-    {
-      tempMuteOn(true);
-      squelchCutoff = true;
-    }
-  }
-  else if(squelchCutoff)
-  {
-    tempMuteOn(false);
-    squelchCutoff = false;
-  }
-
-  // G8PTN: Based on 1.2s interval, update RSSI & SNR
-  if(!(updateCounter++ & 7))
-  {
-    // Show RSSI status only if this condition has changed
-    if(newRSSI != rssi)
-    {
-      rssi = newRSSI;
-      needRedraw = true;
-    }
-    // Show SNR status only if this condition has changed
-    if(newSNR != snr)
-    {
-      snr = newSNR;
-      needRedraw = true;
-    }
-  }
-  return needRedraw;
+  uint32_t left = now - last < period? period - (now - last) : 0;
+  return(left < wait? left : wait);
 }
 
 //
@@ -682,10 +673,17 @@ bool processRssiSnr()
 //
 void loop()
 {
+  PERF_LOOP(PERF_LOOP_ITERATION);
+  PERF_TRACE_BEGIN(PERF_TRACE_LOOP);
   uint32_t currentTime = millis();
   bool needRedraw = false;
 
-  ButtonTracker::State pb1st = pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW);
+  PERF_LOOP_MARK();
+  ButtonTracker::State pb1st = pb1.update(buttonPressed());
+  PERF_LOOP_LAP(PERF_LOOP_BUTTON);
+
+  // Collect encoder steps made since the last iteration
+  encoderCount = encoderRead(&encoderFast);
 
 #ifndef DISABLE_REMOTE
   // Periodically print status to serial
@@ -694,7 +692,9 @@ void loop()
   // Receive and execute serial command
   if(Serial.available()>0)
   {
+    PERF_LOOP_MARK();
     int revent = remoteDoCommand(Serial.read());
+    PERF_LOOP_LAP(PERF_LOOP_REMOTE);
     needRedraw |= !!(revent & REMOTE_CHANGED);
     pb1st.wasClicked |= !!(revent & REMOTE_CLICK);
     int direction = revent >> REMOTE_DIRECTION;
@@ -703,7 +703,9 @@ void loop()
   }
 #endif
 
+  PERF_LOOP_MARK();
   int ble_event = bleDoCommand(bleModeIdx);
+  PERF_LOOP_LAP(PERF_LOOP_BLE);
 
   // Block encoder rotation when in the locked sleep mode
   if(encoderCount && sleepOn() && sleepModeIdx==SLEEP_LOCKED) encoderCount = 0;
@@ -731,7 +733,7 @@ void loop()
           break;
         case CMD_SEEK:
           // Normal tuning in seek mode
-          needRedraw |= doTune(encoderCount);
+          needRedraw |= doTune(encoderCount, encoderFast);
           // Current frequency may have changed
           prefsRequestSave(SAVE_CUR_BAND);
           break;
@@ -757,8 +759,8 @@ void loop()
       {
         case CMD_NONE:
         case CMD_SCAN:
-          // Tuning
-          needRedraw |= doTune(encoderCount);
+          // Tuning, faster when the encoder is spun fast
+          needRedraw |= doTune(encoderCount, encoderFast);
           // Current frequency may have changed
           prefsRequestSave(SAVE_CUR_BAND);
           break;
@@ -881,64 +883,107 @@ void loop()
     elapsedSleep = elapsedCommand = currentTime = millis();
   }
 
-  if((currentTime - elapsedRSSI) > MIN_ELAPSED_RSSI_TIME)
+  // Execute radio commands from the web interface
+  needRedraw |= radioTickTime();
+
+  // User input has priority over the periodic updates below
+  if(needRedraw) drawRequest(DRAW_URGENT);
+
+  // Sample signal quality, faster while tuning and slower when idle
+  if(signalDue(currentTime))
   {
-    needRedraw |= processRssiSnr();
-    elapsedRSSI = currentTime;
+    PERF_LOOP_MARK();
+    if(signalSample()) drawRequest(DRAW_LAZY);
+    PERF_LOOP_LAP(PERF_LOOP_RSSI);
+    // Switch to a stronger alternative frequency if the signal is weak
+    if((currentMode == FM) && (getRDSMode() & RDS_AF) && rdsAfCheck(rssi)) drawRequest(DRAW_LAZY);
   }
 
+  // Check the next channel while scanning memories
+  if(memScanTickTime()) drawRequest(DRAW_LAZY);
+
+  // Periodically check the priority channel
+  if(prioWatchTickTime()) drawRequest(DRAW_LAZY);
+
   // Periodically check received RDS information
-  if((currentTime - lastRDSCheck) > RDS_CHECK_TIME)
+  if((currentTime - lastRDSCheck) >= RDS_CHECK_TIME)
   {
-    needRedraw |= (currentMode == FM) && (snr >= 12) && checkRds();
+    PERF_LOOP_MARK();
+    // Always drain the RDS FIFO, only show what it has at good SNR
+    if((currentMode == FM) && checkRds(snr >= 12)) drawRequest(DRAW_LAZY);
+    PERF_LOOP_LAP(PERF_LOOP_RDS);
     lastRDSCheck = currentTime;
   }
 
   // Periodically check schedule
-  if((currentTime - lastScheduleCheck) > SCHEDULE_CHECK_TIME)
+  if((currentTime - lastScheduleCheck) >= SCHEDULE_CHECK_TIME)
   {
-    needRedraw |= identifyFrequency(currentFrequency + currentBFO / 1000, true);
+    PERF_LOOP_MARK();
+    if(identifyFrequency(currentFrequency + currentBFO / 1000, true)) drawRequest(DRAW_LAZY);
+    PERF_LOOP_LAP(PERF_LOOP_SCHEDULE);
     lastScheduleCheck = currentTime;
   }
 
   // Periodically synchronize time via NTP
-  if((currentTime - lastNTPCheck) > NTP_CHECK_TIME)
+  if((currentTime - lastNTPCheck) >= NTP_CHECK_TIME)
   {
-    needRedraw |= ntpSyncTime();
+    PERF_LOOP_MARK();
+    if(ntpSyncTime()) drawRequest(DRAW_LAZY);
+    PERF_LOOP_LAP(PERF_LOOP_NTP);
     lastNTPCheck = currentTime;
   }
 
   // Tick preferences time, saving changes when there has
   // been no activity for a while
+  PERF_LOOP_MARK();
   prefsTickTime();
+  PERF_LOOP_LAP(PERF_LOOP_PREFS);
 
   // Tick NETWORK time, connecting to WiFi if requested
   netTickTime();
-
-#ifdef ENABLE_HOLDOFF
-  // Check if tuning flag is set
-  if(tuning_flag && ((currentTime - tuning_timer) > TUNE_HOLDOFF_TIME))
-  {
-    tuning_flag = false;
-    needRedraw = true;
-  }
-#endif
+  PERF_LOOP_LAP(PERF_LOOP_NET);
 
   // Run clock
-  needRedraw |= clockTickTime();
+  if(clockTickTime()) drawRequest(DRAW_LAZY);
 
-  // Periodically refresh the main screen
-  // This covers the case where there is nothing else triggering a refresh
-  if(needRedraw) background_timer = currentTime;
-  if((currentTime - background_timer) > BACKGROUND_REFRESH_TIME)
-  {
-    if(currentCmd == CMD_NONE) needRedraw = true;
-    background_timer = currentTime;
-  }
+  // Measure battery voltage
+  if(batteryTickTime()) drawRequest(DRAW_LAZY);
+
+  // Redraw screen if necessary, limiting the frame rate
+  PERF_LOOP_MARK();
+  if(drawTickTime()) PERF_LOOP_LAP(PERF_LOOP_DRAW);
+
+  // Send screen updates to the web clients, if any
+  mirrorTickTime();
+
+  // Send and save captured RDS groups, if any
+  rdsLogTickTime();
+
+  // Sleep until user input arrives or the next periodic task is due.
+  // Other modules' timers run at 100ms or coarser granularity.
+  currentTime = millis();
+  uint32_t wait = EVENT_MAX_WAIT;
+  wait = signalWaitTime(currentTime) < wait? signalWaitTime(currentTime) : wait;
+  wait = memScanWaitTime(currentTime) < wait? memScanWaitTime(currentTime) : wait;
+  wait = prioWatchWaitTime(currentTime) < wait? prioWatchWaitTime(currentTime) : wait;
+  wait = waitTime(wait, currentTime, lastRDSCheck, RDS_CHECK_TIME);
+  wait = drawWaitTime() < wait? drawWaitTime() : wait;
+
+  // Button debouncing and press timing, as well as BLE input, need polling
+  if(pb1st.isPressed || buttonPressed() || bleModeIdx!=BLE_OFF)
+    wait = wait < EVENT_POLL_TIME? wait : EVENT_POLL_TIME;
+
+  // Do not wait while there is input left to process
+  if(encoderPending()) wait = 0;
+#ifndef DISABLE_REMOTE
+  if(Serial.available()>0) wait = 0;
+#endif
 
-  // Redraw screen if necessary
-  if(needRedraw) drawScreen();
+  PERF_TRACE_END(PERF_TRACE_LOOP);
+  PERF_LOOP_MARK();
+  uint8_t events = eventWait(wait);
+  PERF_LOOP_LAP(PERF_LOOP_IDLE);
 
-  // Add a small default delay in the main loop
-  delay(5);
+  // Web API changes have to be shown right away
+  if(events & EVENT_WEB) drawRequest(DRAW_URGENT);
 }
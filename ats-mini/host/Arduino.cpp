@@ -0,0 +1,565 @@
+//
+// Host build: Arduino core, ESP-IDF and FreeRTOS parts used by the
+// firmware, running on the virtual clock
+//
+#include "Host.h"
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+#include <qrcode.h>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+LittleFSFS LittleFS;
+
+#ifdef HOST_STRLCPY
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t len = strlen(src);
+
+  if(size)
+  {
+    size_t n = len < size? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+
+  return(len);
+}
+#endif
+
+//
+// Virtual clock
+//
+static uint64_t now = 0;
+static uint64_t limit = 3600ULL * 1000000ULL;
+static std::multimap<uint64_t, std::function<void()>> actions;
+
+uint64_t hostNow()
+{
+  return(now);
+}
+
+void hostSetLimit(uint64_t time)
+{
+  limit = time;
+}
+
+void hostAt(uint64_t time, std::function<void()> action)
+{
+  actions.emplace(time, action);
+}
+
+bool hostPending()
+{
+  return(!actions.empty());
+}
+
+uint64_t hostNextAction()
+{
+  return(actions.empty()? UINT64_MAX : actions.begin()->first);
+}
+
+void hostAdvance(uint64_t us)
+{
+  uint64_t target = now + us;
+
+  // Run actions due till the target time, including the ones
+  // they schedule
+  while(!actions.empty() && actions.begin()->first <= target)
+  {
+    auto next = actions.begin();
+    std::function<void()> action = next->second;
+
+    now = std::max(now, next->first);
+    actions.erase(next);
+    action();
+  }
+
+  now = std::max(now, target);
+
+  if(now > limit)
+  {
+    fprintf(stderr, "host: time limit of %llus reached\n", (unsigned long long)(limit / 1000000));
+    exit(2);
+  }
+}
+
+// Reading the clock takes a little time, so that loops polling it
+// make progress. Actions due meanwhile run on the next wait.
+#define CLOCK_READ_TIME 1
+
+uint32_t millis()
+{
+  now += CLOCK_READ_TIME;
+  return(now / 1000);
+}
+
+uint32_t micros()
+{
+  now += CLOCK_READ_TIME;
+  return((uint32_t)now);
+}
+
+void delay(uint32_t ms)
+{
+  hostAdvance(ms * 1000ULL);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  hostAdvance(us);
+}
+
+// Render probes measure real time on the host, in 80MHz cycles
+uint32_t EspClass::getCycleCount()
+{
+  static const auto start = std::chrono::steady_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  return((uint32_t)(ns * 80 / 1000));
+}
+
+//
+// GPIO: inputs are driven by the simulation, interrupt handlers
+// run when a driven level changes
+//
+#define HOST_PINS 64
+
+static uint8_t pinLevels[HOST_PINS];
+static void (*pinHandlers[HOST_PINS])();
+static uint8_t wakeupPin = 0xFF;
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if(pin<HOST_PINS && mode==INPUT_PULLUP) pinLevels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if(pin<HOST_PINS) pinLevels[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return(pin<HOST_PINS? pinLevels[pin] : LOW);
+}
+
+void hostSetPin(uint8_t pin, int value)
+{
+  if(pin>=HOST_PINS || pinLevels[pin]==value) return;
+  pinLevels[pin] = value;
+  if(pinHandlers[pin]) pinHandlers[pin]();
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode)
+{
+  if(pin<HOST_PINS) pinHandlers[pin] = handler;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  if(pin<HOST_PINS) pinHandlers[pin] = 0;
+}
+
+// Battery at 4.0V
+uint16_t analogRead(uint8_t pin)
+{
+  return(2350);
+}
+
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution)
+{
+  return(true);
+}
+
+bool ledcWrite(uint8_t pin, uint32_t duty)
+{
+  return(true);
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level)
+{
+  wakeupPin = pin;
+  return(ESP_OK);
+}
+
+// Sleep till the wakeup pin goes low, or there is no more input
+esp_err_t esp_light_sleep_start()
+{
+  while(wakeupPin<HOST_PINS && pinLevels[wakeupPin]!=LOW && hostPending())
+    hostAdvance(hostNextAction() - now);
+
+  return(ESP_OK);
+}
+
+//
+// Serial port
+//
+static std::deque<char> serialInput;
+static bool serialEcho = true;
+
+void hostSerialInput(const char *text)
+{
+  while(*text) serialInput.push_back(*text++);
+}
+
+void hostSerialEcho(bool on)
+{
+  serialEcho = on;
+}
+
+int HardwareSerial::available()
+{
+  return(serialInput.size());
+}
+
+int HardwareSerial::peek()
+{
+  return(serialInput.empty()? -1 : (uint8_t)serialInput.front());
+}
+
+int HardwareSerial::read()
+{
+  if(serialInput.empty()) return(-1);
+
+  int c = (uint8_t)serialInput.front();
+  serialInput.pop_front();
+  return(c);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return(write(&c, 1));
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t size)
+{
+  if(serialEcho) fwrite(buf, 1, size, stdout);
+  return(size);
+}
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+  char buf[512];
+  va_list args;
+
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+
+  return(n>0? write((const uint8_t *)buf, std::min((size_t)n, sizeof(buf) - 1)) : 0);
+}
+
+//
+// FreeRTOS queues, receiving with a timeout waits on the virtual
+// clock for an interrupt handler or a task to send an item
+//
+struct HostQueue
+{
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+  return(new HostQueue{ {}, length, itemSize });
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+  if(queue->items.size() >= queue->length) return(pdFALSE);
+
+  const uint8_t *p = (const uint8_t *)item;
+  queue->items.emplace_back(p, p + queue->itemSize);
+  return(pdTRUE);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+  return(xQueueSend(queue, item, 0));
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+  uint64_t deadline = wait==portMAX_DELAY? UINT64_MAX : now + wait * 1000ULL;
+
+  while(queue->items.empty())
+  {
+    if(now >= deadline) return(pdFALSE);
+
+    // Nothing can arrive before the next scheduled action
+    uint64_t next = std::min(hostNextAction(), deadline);
+    if(next==UINT64_MAX) return(pdFALSE);
+    hostAdvance(next > now? next - now : 0);
+  }
+
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return(pdTRUE);
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+  return(queue->length - queue->items.size());
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+  return(xQueueCreate(1, 0));
+}
+
+//
+// Preferences, kept in memory as "namespace/key" entries
+//
+static std::map<std::string, std::vector<uint8_t>> prefsStore;
+
+static std::string prefsKey(const char *space, const char *key)
+{
+  return(std::string(space) + "/" + key);
+}
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition)
+{
+  snprintf(space, sizeof(space), "%s", name);
+  return(true);
+}
+
+bool Preferences::clear()
+{
+  std::string prefix = prefsKey(space, "");
+
+  for(auto i = prefsStore.begin() ; i != prefsStore.end() ;)
+    i = i->first.compare(0, prefix.size(), prefix)? std::next(i) : prefsStore.erase(i);
+
+  return(true);
+}
+
+bool Preferences::remove(const char *key)
+{
+  return(prefsStore.erase(prefsKey(space, key)) > 0);
+}
+
+bool Preferences::isKey(const char *key)
+{
+  return(prefsStore.count(prefsKey(space, key)) > 0);
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)value;
+  prefsStore[prefsKey(space, key)].assign(p, p + len);
+  return(len);
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen)
+{
+  auto i = prefsStore.find(prefsKey(space, key));
+  if(i == prefsStore.end() || i->second.size() > maxLen) return(0);
+
+  memcpy(buf, i->second.data(), i->second.size());
+  return(i->second.size());
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+  auto i = prefsStore.find(prefsKey(space, key));
+  return(i == prefsStore.end()? 0 : i->second.size());
+}
+
+// One entry per 32 bytes of value, as in the NVS pages
+esp_err_t nvs_get_stats(const char *partition, nvs_stats_t *stats)
+{
+  stats->total_entries   = 126 * 16;
+  stats->used_entries    = 0;
+  stats->namespace_count = 0;
+
+  for(auto &i : prefsStore)
+    stats->used_entries += 1 + (i.second.size() + 31) / 32;
+
+  stats->free_entries = stats->total_entries - stats->used_entries;
+  return(ESP_OK);
+}
+
+esp_err_t nvs_flash_erase()
+{
+  prefsStore.clear();
+  return(ESP_OK);
+}
+
+esp_err_t nvs_flash_erase_partition(const char *partition)
+{
+  return(nvs_flash_erase());
+}
+
+//
+// Files
+//
+namespace fs
+{
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+  return(f && !fseek(f, pos, mode==SeekSet? SEEK_SET : mode==SeekCur? SEEK_CUR : SEEK_END));
+}
+
+size_t File::size() const
+{
+  struct stat st;
+  if(!f) return(0);
+  fflush(f);
+  return(fstat(fileno(f), &st)? 0 : st.st_size);
+}
+
+void FS::hostPath(char *buf, size_t size, const char *path)
+{
+  snprintf(buf, size, "%s%s", root, path);
+}
+
+File FS::open(const char *path, const char *mode, bool create)
+{
+  char name[512];
+  std::string m(mode);
+
+  if(!*root) return(File());
+  hostPath(name, sizeof(name), path);
+
+  // Binary mode is the only mode on the device
+  if(m.find('b') == std::string::npos) m += 'b';
+  return(File(fopen(name, m.c_str())));
+}
+
+bool FS::exists(const char *path)
+{
+  char name[512];
+  struct stat st;
+
+  hostPath(name, sizeof(name), path);
+  return(*root && !stat(name, &st));
+}
+
+bool FS::remove(const char *path)
+{
+  char name[512];
+
+  hostPath(name, sizeof(name), path);
+  return(*root && !::remove(name));
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+  char a[512], b[512];
+
+  hostPath(a, sizeof(a), from);
+  hostPath(b, sizeof(b), to);
+  return(*root && !::rename(a, b));
+}
+
+} // namespace fs
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *label)
+{
+  const char *dir = getenv("HOST_FS_DIR");
+
+  snprintf(root, sizeof(root), "%s", dir && *dir? dir : "littlefs");
+  mkdir(root, 0755);
+  return(true);
+}
+
+bool LittleFSFS::format()
+{
+  char dir[256], name[512];
+  struct dirent *entry;
+  DIR *d;
+
+  if(!*root) begin();
+  snprintf(dir, sizeof(dir), "%s", root);
+  if(!(d = opendir(dir))) return(false);
+
+  while((entry = readdir(d)))
+    if(entry->d_name[0] != '.')
+    {
+      snprintf(name, sizeof(name), "%s/%s", dir, entry->d_name);
+      ::remove(name);
+    }
+
+  closedir(d);
+  return(true);
+}
+
+size_t LittleFSFS::usedBytes()
+{
+  char name[512];
+  struct dirent *entry;
+  struct stat st;
+  size_t used = 0;
+  DIR *d;
+
+  if(!*root || !(d = opendir(root))) return(0);
+
+  while((entry = readdir(d)))
+  {
+    snprintf(name, sizeof(name), "%s/%s", root, entry->d_name);
+    if(entry->d_name[0] != '.' && !stat(name, &st)) used += st.st_size;
+  }
+
+  closedir(d);
+  return(used);
+}
+
+//
+// QR code stand-in: finder patterns in three corners and modules
+// from a hash of the text, the size of a version 2 code
+//
+#define QR_SIZE 25
+
+static uint8_t qrModules[QR_SIZE * QR_SIZE];
+
+int esp_qrcode_get_size(esp_qrcode_handle_t qrcode)
+{
+  return(QR_SIZE);
+}
+
+bool esp_qrcode_get_module(esp_qrcode_handle_t qrcode, int x, int y)
+{
+  return(x>=0 && y>=0 && x<QR_SIZE && y<QR_SIZE && qrcode[y * QR_SIZE + x]);
+}
+
+static bool qrFinder(int x, int y)
+{
+  int d = std::max(abs(x - 3), abs(y - 3));
+  return(d!=2 && d<=3);
+}
+
+int esp_qrcode_generate(esp_qrcode_config_t *cfg, const char *text)
+{
+  uint32_t hash = 2166136261u;
+
+  for(const char *p = text ; *p ; p++) hash = (hash ^ (uint8_t)*p) * 16777619u;
+
+  for(int y=0 ; y<QR_SIZE ; y++)
+    for(int x=0 ; x<QR_SIZE ; x++)
+    {
+      uint8_t *m = &qrModules[y * QR_SIZE + x];
+
+      if(x<8 && y<8)                  *m = qrFinder(x, y);
+      else if(x>=QR_SIZE-8 && y<8)    *m = qrFinder(x - (QR_SIZE - 7), y);
+      else if(x<8 && y>=QR_SIZE-8)    *m = qrFinder(x, y - (QR_SIZE - 7));
+      else
+      {
+        hash ^= hash << 13; hash ^= hash >> 17; hash ^= hash << 5;
+        *m = hash & 1;
+      }
+    }
+
+  if(cfg->display_func) cfg->display_func(qrModules);
+  return(ESP_OK);
+}
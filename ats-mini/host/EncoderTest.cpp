@@ -0,0 +1,127 @@
+//
+// Encoder replay test: queues the steps of a detent timing file the
+// way the interrupt handler does, reads them the way the main loop
+// does, and checks the step counts, the fast tuning flag and the
+// frequency reached with stepOffset(). One command per line:
+//
+//   tune FREQ STEP [FAST]
+//                      Start tuning at FREQ with STEP, or with FAST
+//                      when the encoder is spun fast (default STEP)
+//   T cw|ccw           Encoder detent at T ms
+//   T read N [fast] [FREQ]
+//                      Main loop reads at T ms, expects N steps, the
+//                      fast flag set (or cleared without "fast") and
+//                      the tuned frequency FREQ
+//
+// Reads tune by the steps read at once, the way doTune() does, this
+// must end on the same frequency as tuning one step at a time.
+//
+#include "../Encoder.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *fileName = "";
+static int lineNo = 0;
+static int failures = 0;
+
+static void fail(const char *what, long expected, long got)
+{
+  fprintf(stderr, "%s:%d: FAIL: expected %s %ld, got %ld\n", fileName, lineNo, what, expected, got);
+  failures++;
+}
+
+// Tune one step at a time, each step going to the next step grid
+// point in its direction
+static int32_t tuneSingle(int32_t freq, int count, int32_t step)
+{
+  for( ; count>0 ; count--) freq = (freq / step + 1) * step;
+  for( ; count<0 ; count++) freq = freq % step? freq / step * step : freq - step;
+  return(freq);
+}
+
+int main(int argc, char **argv)
+{
+  int32_t freq = 0, single = 0, step = 1, fastStep = 1;
+  int total = 0, queued = 0, steps = 0;
+  uint32_t last = 0;
+  char buf[256];
+
+  if(argc != 2)
+  {
+    fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+    return(1);
+  }
+
+  fileName = argv[1];
+  FILE *f = fopen(fileName, "r");
+  if(!f)
+  {
+    fprintf(stderr, "%s: cannot open\n", fileName);
+    return(1);
+  }
+
+  while(fgets(buf, sizeof(buf), f))
+  {
+    char cmd[16] = "", arg[2][16] = { "", "" };
+    unsigned time;
+    int n;
+
+    lineNo++;
+    if(buf[strspn(buf, " \t")]=='#' || sscanf(buf, "%15s", cmd) < 1) continue;
+
+    if(!strcmp(cmd, "tune"))
+    {
+      if(sscanf(buf, "%*s %d %d %d", &freq, &step, &fastStep) < 3) fastStep = step;
+      if(step<=0 || fastStep<=0) goto invalid;
+      single = freq;
+      continue;
+    }
+
+    if(sscanf(buf, "%u %15s", &time, cmd) < 2 || time < last) goto invalid;
+    last = time;
+
+    if(!strcmp(cmd, "cw") || !strcmp(cmd, "ccw"))
+    {
+      // The ring keeps up to ENCODER_RING_SIZE steps, drops the rest
+      if(queued < ENCODER_RING_SIZE)
+      {
+        total += !strcmp(cmd, "cw")? 1 : -1;
+        queued++;
+      }
+      encoderQueue(time, !strcmp(cmd, "cw")? 1 : -1);
+      steps++;
+    }
+    else if(!strcmp(cmd, "read") && sscanf(buf, "%*u %*s %d %15s %15s", &n, arg[0], arg[1]) >= 1)
+    {
+      bool expectFast = !strcmp(arg[0], "fast");
+      const char *expectFreq = arg[expectFast];
+      bool fast;
+      int count = encoderRead(&fast);
+      int32_t used = fast? fastStep : step;
+
+      if(count != n) fail("steps", n, count);
+      if(fast != expectFast) fail("fast", expectFast, fast);
+
+      freq  += stepOffset(count, used, freq % used);
+      single = tuneSingle(single, count, used);
+      if(freq != single) fail("frequency", single, freq);
+      if(*expectFreq && freq != atol(expectFreq)) fail("frequency", atol(expectFreq), freq);
+      total -= count;
+      queued = 0;
+    }
+    else goto invalid;
+  }
+
+  fclose(f);
+  lineNo = 0;
+  if(total) fail("steps left", 0, total);
+
+  fprintf(stderr, "%s: %d steps, %s\n", fileName, steps, failures? "FAILED" : "passed");
+  return(failures? 1 : 0);
+
+invalid:
+  fprintf(stderr, "%s:%d: invalid line: %s", fileName, lineNo, buf);
+  fclose(f);
+  return(1);
+}
@@ -0,0 +1,64 @@
+//
+// Host simulation: virtual clock, scripted input and the simulated
+// radio, shared by the stubs and the simulation runners
+//
+#ifndef HOST_H
+#define HOST_H
+
+#include <Arduino.h>
+#include <functional>
+
+//
+// Virtual clock (us since boot). Waiting runs the actions scheduled
+// till the end of the wait, in time order. Waiting past the limit
+// ends the simulation, the firmware is stuck.
+//
+uint64_t hostNow();
+void hostAdvance(uint64_t us);
+void hostAt(uint64_t time, std::function<void()> action);
+uint64_t hostNextAction();
+bool hostPending();
+void hostSetLimit(uint64_t time);
+
+//
+// Input pins and serial port
+//
+void hostSetPin(uint8_t pin, int value);
+void hostSerialInput(const char *text);
+void hostSerialEcho(bool on);
+
+//
+// Simulated radio
+//
+#define HOST_FM   0
+#define HOST_AM   1
+#define HOST_SSB  2
+
+typedef struct
+{
+  uint8_t mode;           // HOST_FM, HOST_AM, HOST_SSB
+  uint32_t freq;          // Carrier (Hz)
+  uint8_t rssi;           // Signal level (dBuV)
+  uint8_t fadeDepth;      // Fading depth (dB), 0 if steady
+  uint16_t fadePeriod;    // Fading period (ms)
+  uint16_t pi;            // RDS PI code, 0 if no RDS
+  uint8_t pty;            // RDS program type
+  const char *ps;         // RDS program service name
+  const char *rt;         // RDS radio text
+  uint16_t af[4];         // RDS alternative frequencies (10kHz)
+  bool stereo;            // FM pilot present
+} HostStation;
+
+const HostStation *hostStations(int *count);
+void hostSetStations(const HostStation *list, int count);
+const HostStation *hostStationAt(uint8_t mode, uint32_t hz);
+void hostRadioSignal(uint32_t hz, uint8_t *rssi, uint8_t *snr);
+uint32_t hostRadioTunes();
+uint32_t hostRadioRdsGroups();
+
+//
+// Screen capture
+//
+bool hostSavePng(const char *path, const uint16_t *pixels, int w, int h);
+
+#endif // HOST_H
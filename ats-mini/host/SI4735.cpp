@@ -0,0 +1,812 @@
+//
+// Host build: simulated SI4732 radio chip
+//
+// Commands take I2C bus time and the chip is busy (CTS low) for a
+// while after each one. Tuning completes (STC) after a settle time,
+// seeking visits one channel per settle time and stops at the first
+// channel passing the RSSI and SNR thresholds, or at the band limit.
+// Signal quality comes from a table of stations with the noise floor
+// of each band, selectivity, slow fading and per reading noise. RDS
+// stations produce 0A, 2A and 4A groups at the real group rate, with
+// block errors getting more frequent as SNR falls.
+//
+// Timing is typical rather than worst case: tuning settles in 20ms
+// on FM and 50ms on AM/SSB, the datasheet maximums are 60 and 80ms.
+//
+#include "Host.h"
+#include <SI4735.h>
+#include <vector>
+
+TwoWire Wire;
+
+#define POWERUP_TIME     110000 // Power up with crystal oscillator (us)
+#define COMMAND_TIME        300 // CTS after a command (us)
+#define PROPERTY_TIME       550 // Library waits after a property (us)
+#define PATCH_CHUNK_TIME     60 // CTS after a patch chunk (us)
+#define WAIT_POLL_TIME      300 // Library CTS polling interval (us)
+#define TUNE_TIME_FM      20000 // Tune settle time (us)
+#define TUNE_TIME_AM      50000
+#define RDS_GROUP_TIME    87600 // 11.4 groups per second (us)
+#define RDS_FIFO_SIZE        25 // Chip RDS FIFO (groups)
+
+// Station, noise and selectivity model
+#define NOISE_FM              6 // Noise floor (dBuV)
+#define NOISE_MW             18
+#define NOISE_SW              8
+#define NOISE_JITTER          2 // Reading to reading noise (dB)
+#define WIDTH_FM         100000 // Channel half width (Hz)
+#define WIDTH_AM           5000
+#define WIDTH_SSB          1500
+#define AFC_RAIL_FM       25000 // Offset failing seek validation (Hz)
+#define AFC_RAIL_AM        2000
+#define SNR_MAX_FM           40
+#define SNR_MAX_AM           35
+#define RDS_SNR_MIN           5 // No RDS sync below this SNR
+#define RDS_SNR_CLEAN        22 // No block errors above this SNR
+
+//
+// Stations on the air, unless a simulation sets its own
+//
+static const HostStation defaultStations[] =
+{
+  // FM, with RDS
+  { HOST_FM,  88100000, 55, 0,     0, 0x5A01, 10, "ROCK FM", "Classic rock all day\r", { 10230 }, true },
+  { HOST_FM,  91500000, 42, 0,     0, 0x5A02,  6, "CLASSIC", "Symphony No. 9 in D minor, Op. 125\r", {}, true },
+  { HOST_FM,  95800000, 30, 0,     0, 0x5A03,  1, "NEWS 24", "News on the hour every hour\r", {}, false },
+  { HOST_FM,  99700000, 38, 0,     0, 0x5A05,  4, "FADE FM", "Fading transmitter test\r", { 10610 }, true },
+  { HOST_FM, 100500000, 14, 0,     0,      0,  0, 0, 0, {}, false },
+  { HOST_FM, 102300000, 35, 0,     0, 0x5A01, 10, "ROCK FM", "Classic rock all day\r", { 8810 }, true },
+  { HOST_FM, 103900000, 50, 0,     0, 0x5A04,  3, "CITY FM", "Traffic and weather for the city\r", {}, true },
+  { HOST_FM, 106100000, 28, 24, 8000, 0x5A05,  4, "FADE FM", "Fading transmitter test\r", { 9970 }, true },
+
+  // LW and MW
+  { HOST_AM,    153000, 40, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,    198000, 50, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,    531000, 45, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,    693000, 60, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,    810000, 35, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,    909000, 50, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,   1089000, 25, 0,     0, 0, 0, 0, 0, {}, false },
+  { HOST_AM,   1215000, 40, 0,     0, 0, 0, 0, 0, {}, false },
+
+  // SW, fading
+  { HOST_AM,   5975000, 30, 10, 6000, 0, 0, 0, 0, {}, false },
+  { HOST_AM,   7325000, 35,  6, 4000, 0, 0, 0, 0, {}, false },
+  { HOST_AM,   9410000, 40, 12, 5000, 0, 0, 0, 0, {}, false },
+  { HOST_AM,  11750000, 32,  8, 7000, 0, 0, 0, 0, {}, false },
+  { HOST_AM,  15400000, 25, 10, 3000, 0, 0, 0, 0, {}, false },
+
+  // SSB
+  { HOST_SSB,  3690000, 28,  6, 3000, 0, 0, 0, 0, {}, false },
+  { HOST_SSB,  7074000, 24,  0,    0, 0, 0, 0, 0, {}, false },
+  { HOST_SSB, 14200000, 30,  8, 4000, 0, 0, 0, 0, {}, false },
+};
+
+static std::vector<HostStation> stations(std::begin(defaultStations), std::end(defaultStations));
+
+#define STATION_COUNT ((int)stations.size())
+
+//
+// Chip state
+//
+typedef struct
+{
+  uint16_t blocks[4];
+  uint8_t errors[4];
+} RdsGroup;
+
+static struct
+{
+  uint8_t mode;           // HOST_FM, HOST_AM, HOST_SSB
+  bool patched;           // SSB patch loaded
+  uint64_t busy;          // CTS low till (us)
+
+  uint16_t freq;          // Tuned or seeking frequency
+  uint64_t tuneStart;     // Last tune or seek start (us)
+  uint64_t tuneDone;      // STC time (us)
+  bool stc;               // STC interrupt pending
+  bool valid;             // Seek stopped on a valid channel
+  bool bltf;              // Seek reached the band limit
+
+  // Seek in progress
+  bool seeking;
+  bool seekUp, seekWrap;
+  uint16_t seekFrom;
+
+  // Properties
+  uint16_t fmBottom, fmTop, fmSpacing, fmSnr, fmRssi;
+  uint16_t amBottom, amTop, amSpacing, amSnr, amRssi;
+  uint8_t rdsEnable;
+  uint8_t rdsThreshold[4];
+
+  // RDS
+  RdsGroup fifo[RDS_FIFO_SIZE];
+  uint8_t fifoHead, fifoCount;
+  bool groupLost;
+  uint64_t rdsTime;       // Next group time (us)
+  uint32_t rdsSequence;
+
+  // Statistics
+  uint32_t tunes;
+  uint32_t groups;
+} chip;
+
+static uint32_t randomState = 0x12345678;
+
+// Deterministic pseudo random numbers
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return(randomState);
+}
+
+const HostStation *hostStations(int *count)
+{
+  *count = STATION_COUNT;
+  return(stations.data());
+}
+
+void hostSetStations(const HostStation *list, int count)
+{
+  stations.assign(list, list + count);
+}
+
+uint32_t hostRadioTunes()
+{
+  return(chip.tunes);
+}
+
+uint32_t hostRadioRdsGroups()
+{
+  return(chip.groups);
+}
+
+//
+// Signal model
+//
+static uint32_t halfWidth(uint8_t mode)
+{
+  return(mode==HOST_FM? WIDTH_FM : mode==HOST_AM? WIDTH_AM : WIDTH_SSB);
+}
+
+static uint8_t noiseFloor(uint32_t hz)
+{
+  return(hz>=30000000? NOISE_FM : hz<=1800000? NOISE_MW : NOISE_SW);
+}
+
+// Station level with fading at the current time (dBuV)
+static double stationLevel(const HostStation *s)
+{
+  if(!s->fadeDepth) return(s->rssi);
+
+  double phase = 2 * M_PI * (double)(hostNow() / 1000 % s->fadePeriod) / s->fadePeriod;
+  return(s->rssi - s->fadeDepth * (0.5 - 0.5 * cos(phase)));
+}
+
+const HostStation *hostStationAt(uint8_t mode, uint32_t hz)
+{
+  for(int i=0 ; i<STATION_COUNT ; i++)
+    if(stations[i].mode==mode && (uint32_t)abs((int64_t)stations[i].freq - hz) < halfWidth(mode) / 2)
+      return(&stations[i]);
+
+  return(0);
+}
+
+// Strongest station heard at the given frequency, its level and offset
+static const HostStation *strongest(uint32_t hz, double *level, uint32_t *offset)
+{
+  const HostStation *best = 0;
+  uint8_t mode = chip.mode==HOST_FM? HOST_FM : HOST_AM;
+
+  *level  = -100;
+  *offset = 0;
+
+  for(int i=0 ; i<STATION_COUNT ; i++)
+  {
+    const HostStation *s = &stations[i];
+
+    // AM and SSB signals can be heard in either mode
+    if((s->mode==HOST_FM) != (mode==HOST_FM)) continue;
+
+    uint32_t d = abs((int64_t)s->freq - hz);
+    double width = halfWidth(chip.mode==HOST_FM? HOST_FM : std::max(s->mode, chip.mode));
+    if(d >= width) continue;
+
+    // Selectivity: 10dB down at half width, 40dB at full width
+    double x = d / width;
+    double l = stationLevel(s) - 40 * x * x;
+    if(l > *level)
+    {
+      best    = s;
+      *level  = l;
+      *offset = d;
+    }
+  }
+
+  return(best);
+}
+
+void hostRadioSignal(uint32_t hz, uint8_t *rssi, uint8_t *snr)
+{
+  uint32_t offset;
+  double level;
+  const HostStation *s = strongest(hz, &level, &offset);
+  double noise = noiseFloor(hz) + (int)(nextRandom() % (2 * NOISE_JITTER + 1)) - NOISE_JITTER;
+  double total = 10 * log10(pow(10, level / 10) + pow(10, noise / 10));
+  double width = halfWidth(chip.mode==HOST_FM? HOST_FM : s? std::max(s->mode, chip.mode) : chip.mode);
+  double ratio = s? level - noise - 3 - 30 * offset / width : 0;
+  int max = chip.mode==HOST_FM? SNR_MAX_FM : SNR_MAX_AM;
+
+  *rssi = (uint8_t)std::min(127.0, std::max(0.0, round(total)));
+  *snr  = (uint8_t)std::min((double)max, std::max(0.0, round(ratio)));
+}
+
+//
+// Frequencies
+//
+static uint32_t toHz(uint16_t freq)
+{
+  if(chip.mode==HOST_FM) return(freq * 10000);
+  return(freq * 1000);
+}
+
+// SSB tuning includes the BFO, which moves the other way
+static uint32_t tunedHz(uint16_t freq, int bfo)
+{
+  return(chip.mode==HOST_SSB? toHz(freq) - bfo : toHz(freq));
+}
+
+static uint64_t settleTime()
+{
+  return(chip.mode==HOST_FM? TUNE_TIME_FM : TUNE_TIME_AM);
+}
+
+static void rdsClear()
+{
+  chip.fifoHead = chip.fifoCount = 0;
+  chip.groupLost = false;
+  chip.rdsTime = chip.tuneDone + 2 * RDS_GROUP_TIME; // Sync takes about two groups
+  chip.rdsSequence = 0;
+}
+
+static void tuneStart(uint16_t freq)
+{
+  uint64_t now = hostNow();
+
+  chip.freq      = freq;
+  chip.tuneStart = now;
+  chip.tuneDone  = now + settleTime();
+  chip.stc       = false;
+  chip.valid     = false;
+  chip.bltf      = false;
+  chip.seeking   = false;
+  chip.tunes++;
+  rdsClear();
+}
+
+//
+// Seek visits one channel per settle time. Returns the channel
+// being checked at the given time, completing the seek once it
+// finds a valid one or reaches the band limit.
+//
+static bool seekValid(uint16_t freq)
+{
+  uint8_t rssi, snr;
+  uint32_t offset;
+  double level;
+  uint32_t hz = toHz(freq);
+
+  // Seek validation fails when AFC is railed off a station
+  if(strongest(hz, &level, &offset) && offset > (chip.mode==HOST_FM? AFC_RAIL_FM : AFC_RAIL_AM))
+    return(false);
+
+  hostRadioSignal(hz, &rssi, &snr);
+  return(chip.mode==HOST_FM?
+    rssi>=chip.fmRssi && snr>=chip.fmSnr :
+    rssi>=chip.amRssi && snr>=chip.amSnr);
+}
+
+static void seekUpdate()
+{
+  uint64_t now = hostNow();
+  bool fm = chip.mode==HOST_FM;
+  uint16_t bottom  = fm? chip.fmBottom : chip.amBottom;
+  uint16_t top     = fm? chip.fmTop : chip.amTop;
+  uint16_t spacing = fm? chip.fmSpacing : chip.amSpacing;
+
+  while(chip.seeking && now >= chip.tuneDone)
+  {
+    // Channel has settled, stop on it if valid
+    if(chip.freq != chip.seekFrom && seekValid(chip.freq))
+    {
+      chip.seeking = false;
+      chip.valid = true;
+      break;
+    }
+
+    int next = chip.freq + (chip.seekUp? spacing : -spacing);
+
+    // Band limit
+    if(next > top || next < bottom)
+    {
+      if(!chip.seekWrap)
+      {
+        chip.seeking = false;
+        chip.bltf = true;
+        break;
+      }
+
+      next = chip.seekUp? bottom : top;
+    }
+
+    // Back where it started
+    if(next == chip.seekFrom)
+    {
+      chip.freq = next;
+      chip.seeking = false;
+      chip.bltf = true;
+      break;
+    }
+
+    chip.freq = next;
+    chip.tuneDone += settleTime();
+  }
+}
+
+//
+// RDS groups
+//
+static uint16_t rdsChars(const char *text, int len, int i)
+{
+  char a = i<len? text[i] : ' ';
+  char b = i+1<len? text[i+1] : ' ';
+  return(((uint8_t)a << 8) | (uint8_t)b);
+}
+
+static void rdsMakeGroup(const HostStation *s, uint32_t n, uint16_t *blocks)
+{
+  uint16_t b = (s->pty << 5);
+  const char *ps = s->ps? s->ps : "";
+  const char *rt = s->rt? s->rt : "";
+  int rtLen = strlen(rt);
+  int rtSegments = std::min(16, (rtLen + 3) / 4);
+
+  blocks[0] = s->pi;
+
+  if(n % 60 == 59)
+  {
+    // 4A clock time, from 12:00 UTC at boot, UTC+1
+    uint32_t minutes = 12 * 60 + hostNow() / 60000000;
+    uint32_t mjd = 60676;
+    blocks[1] = (4 << 12) | b | (mjd >> 15);
+    blocks[2] = ((mjd & 0x7FFF) << 1) | ((minutes / 60 % 24) >> 4);
+    blocks[3] = ((minutes / 60 % 24 & 0x0F) << 12) | ((minutes % 60) << 6) | 2;
+  }
+  else if(n % 2 == 0 || !rtSegments)
+  {
+    // 0A program service name, AF codes in block C
+    uint8_t addr = (n / 2) % 4;
+    uint8_t afCount = 0;
+
+    while(afCount<4 && s->af[afCount]) afCount++;
+
+    blocks[1] = (0 << 12) | b | addr;
+    if(!afCount)
+      blocks[2] = (224 << 8) | 205;
+    else if(addr == 0)
+      blocks[2] = ((224 + afCount) << 8) | ((s->af[0] - 8750) / 10);
+    else
+    {
+      uint8_t i = 1 + 2 * ((addr - 1) % 2);
+      uint8_t hi = i<afCount? (s->af[i] - 8750) / 10 : 205;
+      uint8_t lo = i+1<afCount? (s->af[i+1] - 8750) / 10 : 205;
+      blocks[2] = (hi << 8) | lo;
+    }
+    blocks[3] = rdsChars(ps, strlen(ps), addr * 2);
+  }
+  else
+  {
+    // 2A radio text
+    uint8_t addr = (n / 2) % rtSegments;
+    blocks[1] = (2 << 12) | b | addr;
+    blocks[2] = rdsChars(rt, rtLen, addr * 4);
+    blocks[3] = rdsChars(rt, rtLen, addr * 4 + 2);
+  }
+}
+
+// Block error level for the current SNR, 3 is uncorrectable
+static uint8_t rdsBlockError(uint8_t snr)
+{
+  if(snr >= RDS_SNR_CLEAN) return(0);
+
+  uint32_t p = (RDS_SNR_CLEAN - snr) * 1000 / (RDS_SNR_CLEAN - RDS_SNR_MIN);
+  uint32_t r = nextRandom() % 2000;
+
+  return(r >= p? 0 : r >= p / 2? 1 : r >= p / 4? 2 : 3);
+}
+
+static void rdsUpdate()
+{
+  uint64_t now = hostNow();
+  uint32_t hz = toHz(chip.freq);
+  uint32_t offset;
+  double level;
+
+  if(chip.mode!=HOST_FM || !chip.rdsEnable || chip.seeking || now < chip.tuneDone)
+  {
+    chip.rdsTime = std::max(chip.rdsTime, now);
+    return;
+  }
+
+  const HostStation *s = strongest(hz, &level, &offset);
+
+  for(; chip.rdsTime <= now ; chip.rdsTime += RDS_GROUP_TIME)
+  {
+    uint8_t rssi, snr;
+
+    if(!s || !s->pi || offset > AFC_RAIL_FM) continue;
+    hostRadioSignal(hz, &rssi, &snr);
+    if(snr < RDS_SNR_MIN) continue;
+
+    RdsGroup group;
+    bool drop = false;
+
+    rdsMakeGroup(s, chip.rdsSequence++, group.blocks);
+    for(int i=0 ; i<4 ; i++)
+    {
+      group.errors[i] = rdsBlockError(snr);
+      if(group.errors[i]==3) group.blocks[i] ^= nextRandom() & 0xFFFF;
+      drop |= group.errors[i] > chip.rdsThreshold[i];
+    }
+
+    // Groups with blocks above the error thresholds are not stored
+    if(drop) continue;
+
+    if(chip.fifoCount == RDS_FIFO_SIZE)
+    {
+      chip.fifoHead = (chip.fifoHead + 1) % RDS_FIFO_SIZE;
+      chip.fifoCount--;
+      chip.groupLost = true;
+    }
+
+    chip.fifo[(chip.fifoHead + chip.fifoCount++) % RDS_FIFO_SIZE] = group;
+    chip.groups++;
+  }
+}
+
+//
+// I2C bus, only the patch loading talks to it directly
+//
+uint8_t TwoWire::endTransmission(bool stop)
+{
+  hostAdvance(busTime(written));
+  chip.busy = hostNow() + PATCH_CHUNK_TIME;
+  return(0);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size, bool stop)
+{
+  hostAdvance(busTime(size));
+  pending = size;
+  return(size);
+}
+
+int TwoWire::read()
+{
+  if(!pending) return(-1);
+  pending--;
+  return(hostNow() >= chip.busy? 0x80 : 0x00);
+}
+
+//
+// Library interface
+//
+void SI4735::waitToSend()
+{
+  do
+  {
+    delayMicroseconds(WAIT_POLL_TIME);
+    hostAdvance(Wire.busTime(1));
+  }
+  while(hostNow() < chip.busy);
+}
+
+void SI4735::sendCommand(uint8_t cmd, uint8_t args, uint8_t resp)
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(1 + args));
+  chip.busy = hostNow() + COMMAND_TIME;
+
+  if(resp)
+  {
+    waitToSend();
+    hostAdvance(Wire.busTime(resp));
+  }
+}
+
+void SI4735::sendProperty(uint16_t property, uint16_t value)
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(6));
+  delayMicroseconds(PROPERTY_TIME);
+
+  switch(property)
+  {
+    case 0x1400: chip.fmBottom  = value; break;
+    case 0x1401: chip.fmTop     = value; break;
+    case 0x1402: chip.fmSpacing = value; break;
+    case 0x1403: chip.fmSnr     = value; break;
+    case 0x1404: chip.fmRssi    = value; break;
+    case 0x3400: chip.amBottom  = value; break;
+    case 0x3401: chip.amTop     = value; break;
+    case 0x3402: chip.amSpacing = value; break;
+    case 0x3403: chip.amSnr     = value; break;
+    case 0x3404: chip.amRssi    = value; break;
+  }
+}
+
+int16_t SI4735::getDeviceI2CAddress(uint8_t resetPin)
+{
+  hostAdvance(Wire.busTime(1));
+  return(deviceAddress);
+}
+
+// Power up resets all properties to their defaults and drops the patch
+static void powerUp(uint8_t mode)
+{
+  chip.mode     = mode;
+  chip.patched  = false;
+  chip.busy     = hostNow() + POWERUP_TIME;
+  chip.fmBottom = 8750; chip.fmTop = 10790; chip.fmSpacing = 10; chip.fmSnr = 3;  chip.fmRssi = 20;
+  chip.amBottom = 520;  chip.amTop = 1710;  chip.amSpacing = 10; chip.amSnr = 5;  chip.amRssi = 25;
+  chip.rdsEnable = 0;
+  memset(chip.rdsThreshold, 0, sizeof(chip.rdsThreshold));
+  chip.seeking = false;
+  rdsClear();
+}
+
+void SI4735::setup(uint8_t resetPin, uint8_t defaultFunction)
+{
+  setup(resetPin, 0, defaultFunction);
+}
+
+void SI4735::setup(uint8_t resetPin, int ctsIntEnable, int defaultFunction, int audioMode, uint8_t clockType, uint8_t gpo2Enable)
+{
+  hostAdvance(Wire.busTime(3));
+  powerUp(defaultFunction==FM_BAND_TYPE? HOST_FM : HOST_AM);
+  currentTune = defaultFunction==FM_BAND_TYPE? 0x20 : 0x40;
+  lastMode = defaultFunction==FM_BAND_TYPE? FM_CURRENT_MODE : AM_CURRENT_MODE;
+  waitToSend();
+}
+
+// Chip keeps nothing over a power down, setup() starts it again
+void SI4735::powerDown()
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(1));
+  chip.patched = false;
+  chip.seeking = false;
+}
+
+void SI4735::setFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step)
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(3));
+  powerUp(HOST_FM);
+  currentTune = 0x20;
+  lastMode = FM_CURRENT_MODE;
+  currentStep = step;
+  setFrequency(initialFreq);
+}
+
+void SI4735::setAM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step)
+{
+  // The chip is powered up again only when coming from another mode
+  if(lastMode != AM_CURRENT_MODE)
+  {
+    waitToSend();
+    hostAdvance(Wire.busTime(3));
+    powerUp(HOST_AM);
+  }
+
+  chip.mode = HOST_AM;
+  currentTune = 0x40;
+  lastMode = AM_CURRENT_MODE;
+  currentStep = step;
+  setFrequency(initialFreq);
+}
+
+void SI4735::setSSB(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step, uint8_t usblsb)
+{
+  // Patch firmware is started again, keeping the patch
+  bool patched = chip.patched;
+
+  waitToSend();
+  hostAdvance(Wire.busTime(3));
+  if(lastMode != SSB_CURRENT_MODE)
+  {
+    powerUp(HOST_SSB);
+    chip.patched = patched;
+  }
+
+  if(!chip.patched) fprintf(stderr, "host: SSB mode without the SSB patch\n");
+
+  chip.mode = HOST_SSB;
+  currentTune = 0x40;
+  lastMode = SSB_CURRENT_MODE;
+  currentStep = step;
+  setFrequency(initialFreq);
+}
+
+si47x_firmware_query_library SI4735::queryLibraryId()
+{
+  si47x_firmware_query_library id = {};
+
+  waitToSend();
+  hostAdvance(Wire.busTime(3));
+  powerUp(chip.mode);
+  waitToSend();
+  hostAdvance(Wire.busTime(8));
+
+  id.resp.PN = 32;
+  id.resp.FWMAJOR = '2';
+  id.resp.FWMINOR = '1';
+  id.resp.CHIPREV = 'A';
+  id.resp.LIBRARYID = 8;
+  return(id);
+}
+
+void SI4735::patchPowerUp()
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(3));
+  powerUp(HOST_SSB);
+  chip.patched = true;
+  lastMode = SSB_CURRENT_MODE;
+}
+
+void SI4735::setFrequency(uint16_t freq)
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(isCurrentTuneFM()? 5 : 6));
+  chip.busy = hostNow() + COMMAND_TIME;
+  tuneStart(freq);
+  waitToSend();
+  currentWorkFrequency = freq;
+  delay(maxDelaySetFrequency);
+}
+
+void SI4735::seekStation(uint8_t up_down, uint8_t wrap)
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(isCurrentTuneFM()? 2 : 6));
+  chip.busy = hostNow() + COMMAND_TIME;
+
+  uint16_t from = chip.freq;
+  tuneStart(from);
+  chip.seeking  = true;
+  chip.seekUp   = up_down;
+  chip.seekWrap = wrap;
+  chip.seekFrom = from;
+
+  // First channel is checked after one settle time
+  chip.tuneDone = hostNow();
+}
+
+void SI4735::getStatus(uint8_t INTACK, uint8_t CANCEL)
+{
+  si47x_frequency freq;
+
+  waitToSend();
+  hostAdvance(Wire.busTime(2));
+  seekUpdate();
+
+  // Cancelling a seek leaves the chip on the current channel
+  if(CANCEL && chip.seeking)
+  {
+    chip.seeking  = false;
+    chip.tuneDone = hostNow();
+    chip.stc      = true;
+  }
+
+  if(!chip.seeking && hostNow() >= chip.tuneDone) chip.stc = true;
+
+  waitToSend();
+  hostAdvance(Wire.busTime(8));
+
+  freq.value = chip.freq;
+  currentStatus.resp.STCINT    = chip.stc;
+  currentStatus.resp.VALID     = chip.valid;
+  currentStatus.resp.BLTF      = chip.bltf;
+  currentStatus.resp.READFREQH = freq.raw.FREQH;
+  currentStatus.resp.READFREQL = freq.raw.FREQL;
+
+  if(INTACK) chip.stc = false;
+}
+
+uint16_t SI4735::getFrequency()
+{
+  getStatus(0, 1);
+  currentWorkFrequency = chip.freq;
+  return(chip.freq);
+}
+
+uint16_t SI4735::getAntennaTuningCapacitor()
+{
+  // Varactor follows the frequency on AM, FM uses a fixed value
+  return(chip.mode==HOST_FM? 0 : (uint16_t)(6000 - chip.freq / 5));
+}
+
+void SI4735::getCurrentReceivedSignalQuality(uint8_t INTACK)
+{
+  uint8_t rssi = 0, snr = 0;
+
+  waitToSend();
+  hostAdvance(Wire.busTime(2));
+  waitToSend();
+  hostAdvance(Wire.busTime(isCurrentTuneFM()? 8 : 6));
+  seekUpdate();
+
+  // Nothing to measure while tuning, or in SSB without the patch
+  if(!chip.seeking && hostNow() >= chip.tuneDone && (chip.mode!=HOST_SSB || chip.patched))
+    hostRadioSignal(tunedHz(chip.freq, bfo), &rssi, &snr);
+
+  uint32_t offset;
+  double level;
+  const HostStation *s = strongest(toHz(chip.freq), &level, &offset);
+
+  currentRqsStatus.resp.RSSI  = rssi;
+  currentRqsStatus.resp.SNR   = snr;
+  currentRqsStatus.resp.PILOT = chip.mode==HOST_FM && s && s->stereo && snr >= 20;
+}
+
+void SI4735::setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t BLETHC, uint8_t BLETHD)
+{
+  sendProperty(0x1502, (RDSEN << 0) | (BLETHA << 14) | (BLETHB << 12) | (BLETHC << 10) | (BLETHD << 8));
+  chip.rdsEnable = RDSEN;
+  chip.rdsThreshold[0] = BLETHA;
+  chip.rdsThreshold[1] = BLETHB;
+  chip.rdsThreshold[2] = BLETHC;
+  chip.rdsThreshold[3] = BLETHD;
+}
+
+void SI4735::getRdsStatus(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY)
+{
+  waitToSend();
+  hostAdvance(Wire.busTime(2));
+  waitToSend();
+  hostAdvance(Wire.busTime(13));
+  rdsUpdate();
+
+  si47x_rds_status *st = &currentRdsStatus;
+
+  st->resp.GRPLOST = chip.groupLost;
+  st->resp.RDSFIFOUSED = chip.fifoCount;
+  st->resp.RDSRECV = chip.fifoCount > 0;
+  st->resp.RDSSYNC = chip.fifoCount > 0;
+
+  if(MTFIFO)
+  {
+    chip.fifoHead = chip.fifoCount = 0;
+    chip.groupLost = false;
+    return;
+  }
+
+  if(STATUSONLY || !chip.fifoCount) return;
+
+  const RdsGroup *group = &chip.fifo[chip.fifoHead];
+  chip.fifoHead = (chip.fifoHead + 1) % RDS_FIFO_SIZE;
+  chip.fifoCount--;
+  chip.groupLost = false;
+
+  st->resp.BLOCKAH = group->blocks[0] >> 8; st->resp.BLOCKAL = group->blocks[0] & 0xFF;
+  st->resp.BLOCKBH = group->blocks[1] >> 8; st->resp.BLOCKBL = group->blocks[1] & 0xFF;
+  st->resp.BLOCKCH = group->blocks[2] >> 8; st->resp.BLOCKCL = group->blocks[2] & 0xFF;
+  st->resp.BLOCKDH = group->blocks[3] >> 8; st->resp.BLOCKDL = group->blocks[3] & 0xFF;
+  st->resp.BLEA = group->errors[0];
+  st->resp.BLEB = group->errors[1];
+  st->resp.BLEC = group->errors[2];
+  st->resp.BLED = group->errors[3];
+}
@@ -0,0 +1,673 @@
+//
+// Host simulation runner: boots the firmware on the virtual clock
+// and feeds it the input of a script, one command per line:
+//
+//   wait MS            Let the firmware run for MS milliseconds
+//   click              Click the encoder button
+//   press MS           Hold the encoder button for MS milliseconds
+//   turn N [MS]        Turn the encoder N detents (negative for
+//                      counterclockwise), MS apart (default 100)
+//   serial TEXT        Send TEXT to the serial port
+//   screenshot FILE    Save the screen to a PNG file
+//   set theme|layout N Switch to color theme or UI layout N
+//   expect freq KHZ    Fail unless tuned to KHZ (including BFO)
+//   expect station     Fail unless tuned to a station of the table
+//   expect ps TEXT [MS]
+//   expect pi HEX [MS] Fail unless the RDS station name or PI code
+//                      shows within MS (default 0), print the time
+//   expect scan        Fail unless the last band scan has a peak at
+//                      each station well above the noise, and no
+//                      other peaks
+//   expect screen NAME Fail unless the screen matches the golden
+//                      image golden/NAME.png next to the script
+//   expect patches N   Fail unless the SSB patch has been loaded N
+//                      times since boot
+//   report seek|scan|band
+//                      Print the time to complete these operations
+//   report render      Print the time to render a frame and its parts
+//   report af          Print the RDS alternative frequency checks and
+//                      their longest audio gap
+//   station MODE KHZ DBUV [fade=DB/MS] [pi=HEX] [pty=N] [ps=TEXT]
+//           [rt=TEXT] [af=KHZ,...] [stereo]
+//                      Put a station on the air (fm, am or ssb), '_'
+//                      in the text is a space. The first station
+//                      replaces the built-in station table.
+//
+// Input is scheduled at the script time, the checks and screenshots
+// run between two main loop iterations once that time has passed,
+// so a check following a long operation sees its result.
+//
+// With -u, expect screen saves the golden images instead of comparing.
+// A screen that does not match is saved to build/NAME.png.
+//
+#include "Host.h"
+#include "../Common.h"
+#include "../Utils.h"
+#include "../Events.h"
+#include "../Perf.h"
+#include "../Themes.h"
+#include "../Menu.h"
+#include "../Draw.h"
+#include "../Rds.h"
+#include <png.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+void setup();
+void loop();
+
+#define SIM_CLICK_TIME    150 // Button held for a click (ms)
+#define SIM_RELEASE_TIME  250 // Pause after releasing the button (ms)
+#define SIM_DETENT_TIME   100 // Default time between encoder detents (ms)
+#define SIM_EDGE_TIME       2 // Time between encoder edges (ms)
+#define SIM_SERIAL_TIME   100 // Pause after serial input (ms)
+#define SIM_TIME_LIMIT     60 // Time allowed past the script end (s)
+#define SIM_SPIN_LIMIT  10000 // Main loop iterations without waiting
+#define SIM_SPIN_TIME     100 // Iteration time that is not a wait (us)
+
+static const char *scriptName = "";
+static std::string goldenDir;
+static bool updateGolden = false;
+static int failures = 0;
+
+// Checks waiting for the current main loop iteration to end
+static std::vector<std::function<void()>> deferred;
+
+// Stations set by the script and their texts
+static std::vector<HostStation> stations;
+static std::deque<std::string> stationTexts;
+
+static void simPrint(const char *format, ...)
+{
+  va_list args;
+
+  fprintf(stderr, "%s: %8.3f: ", scriptName, hostNow() / 1e6);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+static void simFail(const char *format, ...)
+{
+  char buf[256];
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+
+  simPrint("FAIL: %s", buf);
+  failures++;
+}
+
+//
+// Run action after the main loop iteration in progress at the
+// given time, waking up the main loop if it is waiting
+//
+static void atLoopEnd(uint64_t time, std::function<void()> action)
+{
+  hostAt(time, [action]() { deferred.push_back(action); eventPost(EVENT_NONE); });
+}
+
+//
+// Screen capture
+//
+static void pixelToRgb(uint16_t p, uint8_t *rgb)
+{
+  // Pixels are byte swapped RGB565
+  uint16_t c = (p >> 8) | (p << 8);
+  rgb[0] = ((c >> 11) & 0x1F) * 255 / 31;
+  rgb[1] = ((c >> 5) & 0x3F) * 255 / 63;
+  rgb[2] = (c & 0x1F) * 255 / 31;
+}
+
+bool hostSavePng(const char *path, const uint16_t *pixels, int w, int h)
+{
+  FILE *f = fopen(path, "wb");
+  if(!f) return(false);
+
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+  png_infop info = png_create_info_struct(png);
+  std::vector<uint8_t> row(w * 3);
+
+  if(setjmp(png_jmpbuf(png)))
+  {
+    png_destroy_write_struct(&png, &info);
+    fclose(f);
+    return(false);
+  }
+
+  png_init_io(png, f);
+  png_set_IHDR(png, info, w, h, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png, info);
+
+  for(int y=0 ; y<h ; y++)
+  {
+    for(int x=0 ; x<w ; x++) pixelToRgb(pixels[y * w + x], &row[x * 3]);
+    png_write_row(png, row.data());
+  }
+
+  png_write_end(png, info);
+  png_destroy_write_struct(&png, &info);
+  return(!fclose(f));
+}
+
+// Load an 8-bit RGB image, as saved by hostSavePng()
+static bool loadPng(const std::string &path, std::vector<uint8_t> &rgb, int *w, int *h)
+{
+  FILE *f = fopen(path.c_str(), "rb");
+  if(!f) return(false);
+
+  png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+  png_infop info = png_create_info_struct(png);
+
+  if(setjmp(png_jmpbuf(png)))
+  {
+    png_destroy_read_struct(&png, &info, 0);
+    fclose(f);
+    return(false);
+  }
+
+  png_init_io(png, f);
+  png_read_info(png, info);
+  if(png_get_color_type(png, info)!=PNG_COLOR_TYPE_RGB || png_get_bit_depth(png, info)!=8)
+    png_error(png, "not an 8-bit RGB image");
+
+  *w = png_get_image_width(png, info);
+  *h = png_get_image_height(png, info);
+  rgb.resize(*w * *h * 3);
+  for(int y=0 ; y<*h ; y++) png_read_row(png, &rgb[y * *w * 3], 0);
+
+  png_read_end(png, 0);
+  png_destroy_read_struct(&png, &info, 0);
+  fclose(f);
+  return(true);
+}
+
+static void screenshot(const std::string &path)
+{
+  if(!hostSavePng(path.c_str(), (const uint16_t *)tft.getPointer(), tft.width(), tft.height()))
+    simFail("cannot save %s", path.c_str());
+}
+
+static void expectScreen(const std::string &name)
+{
+  const uint16_t *pixels = (const uint16_t *)tft.getPointer();
+  std::string golden = goldenDir + name + ".png";
+  std::vector<uint8_t> rgb;
+  int w, h, diff = 0;
+
+  if(updateGolden)
+  {
+    screenshot(golden);
+    return;
+  }
+
+  if(!loadPng(golden, rgb, &w, &h))
+  {
+    simFail("cannot load %s", golden.c_str());
+    return;
+  }
+
+  if(w!=tft.width() || h!=tft.height())
+  {
+    simFail("%s is %dx%d, the screen is %dx%d", golden.c_str(), w, h, tft.width(), tft.height());
+    return;
+  }
+
+  for(int i=0 ; i<w*h ; i++)
+  {
+    uint8_t p[3];
+    pixelToRgb(pixels[i], p);
+    diff += !!memcmp(p, &rgb[i * 3], 3);
+  }
+
+  if(diff)
+  {
+    simFail("screen differs from %s in %d pixels, saved to build/%s.png", golden.c_str(), diff, name.c_str());
+    screenshot("build/" + name + ".png");
+  }
+}
+
+//
+// Input
+//
+static void buttonAt(uint64_t time, uint32_t ms)
+{
+  hostAt(time, []() { hostSetPin(ENCODER_PUSH_BUTTON, LOW); });
+  hostAt(time + ms * 1000ULL, []() { hostSetPin(ENCODER_PUSH_BUTTON, HIGH); });
+}
+
+// One detent is a full gray code cycle, the rotary decoder
+// reports it on the last edge
+static void detentAt(uint64_t time, bool cw)
+{
+  static const uint8_t edges[2][4][2] =
+  {
+    { { ENCODER_PIN_B, LOW }, { ENCODER_PIN_A, LOW }, { ENCODER_PIN_B, HIGH }, { ENCODER_PIN_A, HIGH } },
+    { { ENCODER_PIN_A, LOW }, { ENCODER_PIN_B, LOW }, { ENCODER_PIN_A, HIGH }, { ENCODER_PIN_B, HIGH } },
+  };
+
+  for(int i=0 ; i<4 ; i++)
+  {
+    uint8_t pin = edges[cw][i][0], level = edges[cw][i][1];
+    hostAt(time + i * SIM_EDGE_TIME * 1000ULL, [pin, level]() { hostSetPin(pin, level); });
+  }
+}
+
+static void serialAt(uint64_t time, const std::string &text)
+{
+  hostAt(time, [text]() { hostSerialInput(text.c_str()); eventPost(EVENT_SERIAL); });
+}
+
+//
+// Checks
+//
+static uint32_t tunedHz()
+{
+  return(freqToHz(currentFrequency, currentMode) + currentBFO);
+}
+
+static void expectFreq(double khz)
+{
+  uint32_t hz = tunedHz();
+
+  if(hz != (uint32_t)(khz * 1000 + 0.5))
+    simFail("expected %.3fkHz, tuned to %.3fkHz", khz, hz / 1e3);
+}
+
+static void expectPatches(uint32_t count)
+{
+  if(rx.getPatchLoads() != count)
+    simFail("expected %u SSB patch loads, got %u", count, rx.getPatchLoads());
+}
+
+// Station name as shown, RDS names are padded with spaces
+static std::string stationName()
+{
+  std::string name(getStationName());
+  return(name.substr(0, name.find_last_not_of(' ') + 1));
+}
+
+static void expectStation()
+{
+  uint32_t hz = tunedHz();
+
+  if(!hostStationAt(currentMode==FM? HOST_FM : isSSB()? HOST_SSB : HOST_AM, hz))
+    simFail("no station at %.3fkHz", hz / 1e3);
+}
+
+//
+// Poll a condition after each main loop iteration until the
+// time limit, printing the time it took to become true
+//
+static void expectWithin(const std::string &what, uint64_t start, uint64_t limit, std::function<bool()> check)
+{
+  if(check())
+    simPrint("%s after %llums", what.c_str(), (unsigned long long)((hostNow() - start) / 1000));
+  else if(hostNow() >= start + limit)
+    simFail("no %s within %llums", what.c_str(), (unsigned long long)(limit / 1000));
+  else
+    deferred.push_back([=]() { expectWithin(what, start, limit, check); });
+}
+
+//
+// Scan data is kept per channel, the channel grid starts at the scan
+// start, which may be off the step grid. Readings on both sides of a
+// frequency include the channel nearest to it.
+//
+static float scanLevel(int freq, int step)
+{
+  return(std::max(scanGetRSSI(freq - step / 2), scanGetRSSI(freq + step / 2)));
+}
+
+static void expectScan()
+{
+  const int step = 10;
+  const HostStation *list;
+  int count, found = 0, missed = 0, other = 0;
+  uint8_t mode = currentMode==FM? HOST_FM : HOST_AM;
+  uint32_t unit = mode==HOST_FM? 10000 : 1000;
+  std::vector<int> freqs;
+
+  list = hostStations(&count);
+  for(int i=0 ; i<count ; i++)
+  {
+    const HostStation *s = &list[i];
+    int freq = (s->freq + unit / 2) / unit;
+
+    // Stations out of the scanned range read as 0
+    if((s->mode==HOST_FM) != (mode==HOST_FM) || !scanLevel(freq, step)) continue;
+    freqs.push_back(freq);
+
+    // Only stations well above the noise are expected to stand out
+    uint8_t rssi, snr;
+    hostRadioSignal(s->freq, &rssi, &snr);
+    if(snr < 10) continue;
+
+    float level = scanLevel(freq, step);
+    if(level >= scanLevel(freq - step, step) && level >= scanLevel(freq + step, step))
+      found++;
+    else
+    {
+      simFail("scan missed the station at %ukHz", s->freq / 1000);
+      missed++;
+    }
+  }
+
+  // Peaks in the upper half of the range, away from any station
+  for(int freq = step ; freq < 0xFFFF - step ; freq++)
+  {
+    float level = scanGetRSSI(freq);
+    if(level < 0.5 || level < scanGetRSSI(freq - step) || level < scanGetRSSI(freq + step)) continue;
+
+    bool near = false;
+    for(int f : freqs) near |= abs(f - freq) <= step;
+    if(!near)
+    {
+      simFail("scan peak with no station at %ukHz", freqToHz(freq, currentMode) / 1000);
+      other++;
+    }
+
+    // Next channel
+    freq += step - 1;
+  }
+
+  simPrint("scan: %d stations found, %d missed, %d false peaks", found, missed, other);
+}
+
+static void reportRender()
+{
+  PerfStats stats;
+
+  if(!perfRenderStats(PERF_DRAW_FRAME, &stats))
+  {
+    simPrint("render: no frames");
+    return;
+  }
+
+  // Host CPU time, only comparable between runs on the same computer
+  simPrint("render: %u frames, average %uus, 99%% under %uus", stats.count, stats.avg, stats.p99);
+  for(uint8_t id=PERF_DRAW_FRAME+1 ; id<PERF_DRAW_COUNT ; id++)
+    if(perfRenderStats(id, &stats))
+      simPrint("render: %-9s %5u calls, average %uus", perfRenderName(id), stats.count, stats.avg);
+}
+
+static void reportAf()
+{
+  const RdsStats *stats = rdsGetStats();
+
+  simPrint("af: %u checks, %u probes, %u switches, %u timeouts, longest gap %ums",
+    stats->afChecks, stats->afProbes, stats->afSwitches, stats->afTimeouts, stats->afGapMax);
+}
+
+static void report(const char *name, uint8_t id)
+{
+  const PerfHistogram *h = perfLoopHistogram(id);
+
+  if(!h->count)
+    simPrint("%s: not run", name);
+  else
+    simPrint("%s: %u runs, average %.1fms, longest %.1fms",
+      name, h->count, h->total / 1e3 / h->count, h->max / 1e3);
+}
+
+//
+// Station table
+//
+static const char *stationText(const char *text)
+{
+  stationTexts.push_back(text);
+  std::string &t = stationTexts.back();
+  std::replace(t.begin(), t.end(), '_', ' ');
+  return(t.c_str());
+}
+
+static bool parseStation(const char *arg)
+{
+  HostStation s = {};
+  char mode[8], key[16], value[128];
+  double khz;
+  int rssi, pos, n = 0;
+
+  if(sscanf(arg, "%7s %lf %d%n", mode, &khz, &rssi, &pos) < 3) return(false);
+
+  s.mode = !strcmp(mode, "fm")? HOST_FM : !strcmp(mode, "am")? HOST_AM : !strcmp(mode, "ssb")? HOST_SSB : 0xFF;
+  s.freq = khz * 1000 + 0.5;
+  s.rssi = rssi;
+  if(s.mode==0xFF) return(false);
+
+  for(arg += pos ; sscanf(arg, " %15[^= ]%n", key, &pos)==1 ; arg += pos)
+  {
+    arg += pos;
+    pos = 0;
+    if(!strcmp(key, "stereo")) { s.stereo = true; continue; }
+    if(sscanf(arg, "=%127s%n", value, &pos) < 1) return(false);
+
+    if(!strcmp(key, "fade"))
+    {
+      int depth, period;
+      if(sscanf(value, "%d/%d", &depth, &period) < 2) return(false);
+      s.fadeDepth  = depth;
+      s.fadePeriod = period;
+    }
+    else if(!strcmp(key, "pi"))  s.pi  = strtoul(value, 0, 16);
+    else if(!strcmp(key, "pty")) s.pty = atoi(value);
+    else if(!strcmp(key, "ps"))  s.ps  = stationText(value);
+    else if(!strcmp(key, "rt"))  s.rt  = stationText((value + std::string("\r")).c_str());
+    else if(!strcmp(key, "af"))
+    {
+      n = 0;
+      for(char *p = strtok(value, ",") ; p && n<4 ; p = strtok(0, ","))
+        s.af[n++] = atof(p) / 10;
+    }
+    else return(false);
+  }
+
+  stations.push_back(s);
+  return(true);
+}
+
+//
+// Script
+//
+static bool parseLine(const std::string &line, uint64_t *t)
+{
+  char cmd[32] = "", arg[256] = "";
+  int n = sscanf(line.c_str(), " %31s %255[^\n]", cmd, arg);
+  std::string text(arg);
+
+  if(n<1 || cmd[0]=='#') return(true);
+
+  if(!strcmp(cmd, "wait") && n==2)
+  {
+    *t += atoi(arg) * 1000ULL;
+  }
+  else if(!strcmp(cmd, "click"))
+  {
+    buttonAt(*t, SIM_CLICK_TIME);
+    *t += (SIM_CLICK_TIME + SIM_RELEASE_TIME) * 1000ULL;
+  }
+  else if(!strcmp(cmd, "press") && n==2)
+  {
+    buttonAt(*t, atoi(arg));
+    *t += (atoi(arg) + SIM_RELEASE_TIME) * 1000ULL;
+  }
+  else if(!strcmp(cmd, "turn") && n==2)
+  {
+    int detents = 0, ms = SIM_DETENT_TIME;
+    if(sscanf(arg, "%d %d", &detents, &ms) < 1 || ms < 4 * SIM_EDGE_TIME) return(false);
+
+    for(int i=0 ; i<abs(detents) ; i++, *t += ms * 1000ULL)
+      detentAt(*t, detents > 0);
+  }
+  else if(!strcmp(cmd, "serial") && n==2)
+  {
+    serialAt(*t, text);
+    *t += SIM_SERIAL_TIME * 1000ULL;
+  }
+  else if(!strcmp(cmd, "screenshot") && n==2)
+  {
+    atLoopEnd(*t, [text]() { screenshot(text); });
+  }
+  else if(!strcmp(cmd, "set") && n==2)
+  {
+    char what[32];
+    int value;
+
+    if(sscanf(arg, "%31s %d", what, &value) < 2) return(false);
+
+    if(!strcmp(what, "theme") && value>=0 && value<getTotalThemes())
+      atLoopEnd(*t, [value]() { themeIdx = value; drawRequest(DRAW_URGENT); });
+    else if(!strcmp(what, "layout") && value>=0 && value<getTotalUiLayouts())
+      atLoopEnd(*t, [value]() { uiLayoutIdx = value; drawRequest(DRAW_URGENT); });
+    else
+      return(false);
+  }
+  else if(!strcmp(cmd, "expect") && n==2)
+  {
+    char what[32];
+    double khz;
+    unsigned count;
+
+    char value[128] = "";
+    int ms = 0;
+    int n = sscanf(arg, "%31s %127s %d", what, value, &ms);
+    uint64_t deadline = ms * 1000ULL;
+
+    if(n==2 && !strcmp(what, "freq") && sscanf(value, "%lf", &khz)==1)
+      atLoopEnd(*t, [khz]() { expectFreq(khz); });
+    else if(n==1 && !strcmp(what, "station"))
+      atLoopEnd(*t, expectStation);
+    else if(n==1 && !strcmp(what, "scan"))
+      atLoopEnd(*t, expectScan);
+    else if(n==2 && !strcmp(what, "patches") && sscanf(value, "%u", &count)==1)
+      atLoopEnd(*t, [count]() { expectPatches(count); });
+    else if(n==2 && !strcmp(what, "screen"))
+      atLoopEnd(*t, [name = std::string(value)]() { expectScreen(name); });
+    else if(n>=2 && !strcmp(what, "ps"))
+    {
+      std::string ps(value);
+      std::replace(ps.begin(), ps.end(), '_', ' ');
+      atLoopEnd(*t, [ps, deadline]() {
+        expectWithin("ps \"" + ps + "\"", hostNow(), deadline, [ps]() { return(ps == stationName()); });
+      });
+    }
+    else if(n>=2 && !strcmp(what, "pi"))
+    {
+      uint16_t pi = strtoul(value, 0, 16);
+      atLoopEnd(*t, [pi, value = std::string(value), deadline]() {
+        expectWithin("pi " + value, hostNow(), deadline, [pi]() { return(pi == getRdsPiCode()); });
+      });
+    }
+    else
+      return(false);
+  }
+  else if(!strcmp(cmd, "report") && text=="render")
+  {
+    atLoopEnd(*t, reportRender);
+  }
+  else if(!strcmp(cmd, "report") && text=="af")
+  {
+    atLoopEnd(*t, reportAf);
+  }
+  else if(!strcmp(cmd, "report") && n==2)
+  {
+    uint8_t id = text=="seek"? PERF_LOOP_SEEK : text=="scan"? PERF_LOOP_SCAN : text=="band"? PERF_LOOP_BAND : 0xFF;
+    if(id==0xFF) return(false);
+    atLoopEnd(*t, [text, id]() { report(text.c_str(), id); });
+  }
+  else if(!strcmp(cmd, "station") && n==2)
+  {
+    return(parseStation(arg));
+  }
+  else
+  {
+    return(false);
+  }
+
+  return(true);
+}
+
+static bool loadScript(const char *path, uint64_t *end)
+{
+  FILE *f = fopen(path, "r");
+  char buf[512];
+  int lineNo = 0;
+  uint64_t t = 0;
+
+  if(!f)
+  {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return(false);
+  }
+
+  while(fgets(buf, sizeof(buf), f))
+  {
+    lineNo++;
+    buf[strcspn(buf, "\r\n")] = '\0';
+    if(!parseLine(buf, &t))
+    {
+      fprintf(stderr, "%s:%d: invalid command: %s\n", path, lineNo, buf);
+      fclose(f);
+      return(false);
+    }
+  }
+
+  fclose(f);
+  *end = t;
+  return(true);
+}
+
+int main(int argc, char **argv)
+{
+  uint64_t end;
+  int arg = 1;
+
+  for( ; arg<argc && argv[arg][0]=='-' ; arg++)
+  {
+    if(!strcmp(argv[arg], "-q")) hostSerialEcho(false);
+    else if(!strcmp(argv[arg], "-u")) updateGolden = true;
+    else break;
+  }
+
+  if(arg != argc - 1)
+  {
+    fprintf(stderr, "Usage: %s [-q] [-u] SCRIPT\n", argv[0]);
+    return(1);
+  }
+
+  scriptName = argv[arg];
+  goldenDir = std::string(scriptName).substr(0, std::string(scriptName).find_last_of('/') + 1) + "golden/";
+  if(!loadScript(scriptName, &end)) return(1);
+  if(!stations.empty()) hostSetStations(stations.data(), stations.size());
+  hostSetLimit(end + SIM_TIME_LIMIT * 1000000ULL);
+
+  setup();
+
+  // Run till the script is done and its checks have run
+  for(uint32_t spins = 0 ; hostNow() < end || hostPending() || !deferred.empty() ; )
+  {
+    uint64_t start = hostNow();
+    loop();
+
+    // The virtual clock mostly moves when the firmware waits, a main
+    // loop that never waits would use all CPU time on the device
+    spins = hostNow() - start < SIM_SPIN_TIME? spins + 1 : 0;
+    if(spins >= SIM_SPIN_LIMIT)
+    {
+      simFail("main loop does not wait");
+      return(1);
+    }
+
+    std::vector<std::function<void()>> actions;
+    actions.swap(deferred);
+    for(auto &action : actions) action();
+  }
+
+  simPrint("%s", failures? "FAILED" : "passed");
+  return(failures? 1 : 0);
+}
@@ -0,0 +1,9 @@
+//
+// Host build: the sketch, with the prototypes the Arduino builder
+// would generate for functions used before their definition
+//
+#include "../Common.h"
+
+void rotaryEncoder();
+
+#include "../ats-mini.ino"
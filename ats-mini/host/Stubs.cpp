@@ -0,0 +1,19 @@
+//
+// Host build: network and Bluetooth are off, Network.cpp, Ble.cpp,
+// WebApi.cpp and WebUi.cpp are replaced by these stubs
+//
+#include "../Common.h"
+
+int8_t getWiFiStatus() { return(0); }
+char *getWiFiIPAddress() { static char ip[1] = ""; return(ip); }
+void netInit(uint8_t netMode, bool showStatus) {}
+void netStop() {}
+bool ntpIsAvailable() { return(false); }
+bool ntpSyncTime() { return(false); }
+void netRequestConnect() {}
+void netTickTime() {}
+
+int bleDoCommand(uint8_t bleModeIdx) { return(0); }
+void bleInit(uint8_t bleMode) {}
+void bleStop() {}
+int8_t getBleStatus() { return(0); }
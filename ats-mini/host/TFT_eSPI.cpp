@@ -0,0 +1,624 @@
+#include <TFT_eSPI.h>
+#include <vector>
+
+const GFXfont Orbitron_Light_24 = { 24 };
+
+// Byte swapped RGB565, as stored in the sprites
+#define SWAP(c) ((uint16_t)(((c) >> 8) | ((c) << 8)))
+
+//
+// Classic 5x7 font, columns with LSB on top, bit 7 for descenders
+//
+static const uint8_t glcd[95][5] =
+{
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, // ' ' !
+  { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // " #
+  { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, // $ %
+  { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x08, 0x07, 0x03, 0x00 }, // & '
+  { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // ( )
+  { 0x2A, 0x1C, 0x7F, 0x1C, 0x2A }, { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // * +
+  { 0x00, 0x80, 0x70, 0x30, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, // , -
+  { 0x00, 0x00, 0x60, 0x60, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 }, // . /
+  { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // 0 1
+  { 0x72, 0x49, 0x49, 0x49, 0x46 }, { 0x21, 0x41, 0x49, 0x4D, 0x33 }, // 2 3
+  { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, // 4 5
+  { 0x3C, 0x4A, 0x49, 0x49, 0x31 }, { 0x41, 0x21, 0x11, 0x09, 0x07 }, // 6 7
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x46, 0x49, 0x49, 0x29, 0x1E }, // 8 9
+  { 0x00, 0x00, 0x14, 0x00, 0x00 }, { 0x00, 0x40, 0x34, 0x00, 0x00 }, // : ;
+  { 0x00, 0x08, 0x14, 0x22, 0x41 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, // < =
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x59, 0x09, 0x06 }, // > ?
+  { 0x3E, 0x41, 0x5D, 0x59, 0x4E }, { 0x7C, 0x12, 0x11, 0x12, 0x7C }, // @ A
+  { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // B C
+  { 0x7F, 0x41, 0x41, 0x41, 0x3E }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // D E
+  { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x41, 0x51, 0x73 }, // F G
+  { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // H I
+  { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // J K
+  { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x1C, 0x02, 0x7F }, // L M
+  { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // N O
+  { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // P Q
+  { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x26, 0x49, 0x49, 0x49, 0x32 }, // R S
+  { 0x03, 0x01, 0x7F, 0x01, 0x03 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // T U
+  { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // V W
+  { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x03, 0x04, 0x78, 0x04, 0x03 }, // X Y
+  { 0x61, 0x59, 0x49, 0x4D, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x41 }, // Z [
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x41, 0x7F }, // \ ]
+  { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 }, // ^ _
+  { 0x00, 0x03, 0x07, 0x08, 0x00 }, { 0x20, 0x54, 0x54, 0x78, 0x40 }, // ` a
+  { 0x7F, 0x28, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x28 }, // b c
+  { 0x38, 0x44, 0x44, 0x28, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, // d e
+  { 0x00, 0x08, 0x7E, 0x09, 0x02 }, { 0x18, 0xA4, 0xA4, 0x9C, 0x78 }, // f g
+  { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, // h i
+  { 0x20, 0x40, 0x40, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 }, // j k
+  { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x78, 0x04, 0x78 }, // l m
+  { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, // n o
+  { 0xFC, 0x18, 0x24, 0x24, 0x18 }, { 0x18, 0x24, 0x24, 0x18, 0xFC }, // p q
+  { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x24 }, // r s
+  { 0x04, 0x04, 0x3F, 0x44, 0x24 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, // t u
+  { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C }, // v w
+  { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x4C, 0x90, 0x90, 0x90, 0x7C }, // x y
+  { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, // z {
+  { 0x00, 0x00, 0x77, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, // | }
+  { 0x02, 0x01, 0x02, 0x04, 0x02 },                                   // ~
+};
+
+//
+// Scaled 5x7 font sizes: cell height, glyph height, horizontal
+// scale and spacing between glyphs
+//
+typedef struct
+{
+  int16_t height;
+  int16_t glyphHeight;
+  uint8_t scaleNum, scaleDen;
+  uint8_t spacing;
+} FontSize;
+
+static const FontSize font2    = { 16, 14, 3, 2, 1 };
+static const FontSize font4    = { 26, 22, 5, 2, 2 };
+static const FontSize fontFree = { 24, 20, 2, 1, 2 };
+
+// 7-segment font: digit and separator widths, segment thickness
+#define SEG_WIDTH   32
+#define SEG_HEIGHT  48
+#define SEG_NARROW  12
+#define SEG_T        5
+
+// Segments a-g of digits 0-9, bit 0 is segment a
+static const uint8_t segDigits[10] =
+{ 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F };
+
+// Segment rectangles within a digit cell: x, y, w, h
+static const int8_t segRects[7][4] =
+{
+  {  4,  0, 23, SEG_T }, // a
+  { 24,  2, SEG_T, 21 }, // b
+  { 24, 25, SEG_T, 21 }, // c
+  {  4, 43, 23, SEG_T }, // d
+  {  2, 25, SEG_T, 21 }, // e
+  {  2,  2, SEG_T, 21 }, // f
+  {  4, 21, 23, SEG_T }, // g
+};
+
+static bool inRect(const int8_t *r, int x, int y)
+{
+  return(x>=r[0] && y>=r[1] && x<r[0] + r[2] && y<r[1] + r[3]);
+}
+
+// Font 7 glyph pixel, TRUE if lit
+static bool segPixel(char c, int x, int y)
+{
+  static const int8_t dot[4] = { 3, SEG_HEIGHT - SEG_T, SEG_T, SEG_T };
+  static const int8_t colon[2][4] = { { 3, 14, SEG_T, SEG_T }, { 3, 30, SEG_T, SEG_T } };
+
+  if(isdigit(c))
+  {
+    for(int s=0 ; s<7 ; s++)
+      if((segDigits[c - '0'] & (1 << s)) && inRect(segRects[s], x, y)) return(true);
+    return(false);
+  }
+
+  switch(c)
+  {
+    case '-': return(inRect(segRects[6], x, y));
+    case '.': return(inRect(dot, x, y));
+    case ':': return(inRect(colon[0], x, y) || inRect(colon[1], x, y));
+    default:  return(false);
+  }
+}
+
+//
+// TFT_eSPI keeps font 7 run-length encoded, up to 128 pixels per
+// byte with bit 7 set for the foreground, and draws a glyph with a
+// background color one pixel at a time over the whole glyph cell.
+// The glyphs are encoded and drawn the same way here, so that the
+// cost of drawString() compares with copying pixels as on the device.
+//
+static const std::vector<uint8_t> &segRle(char c, int w)
+{
+  static std::vector<uint8_t> rle[128];
+  std::vector<uint8_t> &r = rle[c & 0x7F];
+
+  if(r.empty())
+  {
+    for(int i=0 ; i<w * SEG_HEIGHT ; )
+    {
+      bool lit = segPixel(c, i % w, i / w);
+      int n;
+
+      for(n=1 ; n<128 && i + n<w * SEG_HEIGHT && segPixel(c, (i + n) % w, (i + n) / w)==lit ; n++);
+      r.push_back((lit? 0x80 : 0x00) | (n - 1));
+      i += n;
+    }
+  }
+
+  return(r);
+}
+
+static const FontSize *fontSize(uint8_t font, const GFXfont *gfx)
+{
+  switch(font)
+  {
+    case 1: return(gfx? &fontFree : 0);
+    case 2: return(&font2);
+    case 4: return(&font4);
+    default: return(0);
+  }
+}
+
+static const uint8_t *glyphBits(char c)
+{
+  return(c>=' ' && c<='~'? glcd[c - ' '] : glcd['?' - ' ']);
+}
+
+// Columns of the 5x7 glyph that have ink, first and count
+static void glyphInk(char c, int *first, int *count)
+{
+  const uint8_t *bits = glyphBits(c);
+  int a, b;
+
+  for(a=0 ; a<5 && !bits[a] ; a++);
+  for(b=4 ; b>=a && !bits[b] ; b--);
+
+  *first = a<5? a : 0;
+  *count = a<5? b - a + 1 : 3;
+}
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) :
+  buf(w*h? (uint16_t *)calloc(w * h, sizeof(uint16_t)) : 0), w(w), h(h), dispOn(true),
+  textFg(TFT_WHITE), textBg(TFT_WHITE), textDatum(TL_DATUM), textSize(1), textFont(1),
+  gfxFont(0), cursorX(0), cursorY(0)
+{
+}
+
+TFT_eSPI::~TFT_eSPI()
+{
+  free(buf);
+}
+
+void TFT_eSPI::setRotation(uint8_t r)
+{
+  if((r & 1) != (w > h)) std::swap(w, h);
+}
+
+void TFT_eSPI::writecommand(uint8_t c)
+{
+  if(c==ST7789_DISPOFF) dispOn = false;
+  if(c==ST7789_DISPON)  dispOn = true;
+}
+
+//
+// Graphics primitives, following the Adafruit GFX algorithms used
+// by TFT_eSPI, without anti-aliasing
+//
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+  if(x>=0 && y>=0 && x<w && y<h) buf[y * w + x] = SWAP((uint16_t)color);
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y)
+{
+  return(x>=0 && y>=0 && x<w && y<h? SWAP(buf[y * w + x]) : 0);
+}
+
+void TFT_eSPI::hline(int32_t x0, int32_t x1, int32_t y, uint16_t color)
+{
+  fillRect(x0, y, x1 - x0 + 1, 1, color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color)
+{
+  if(x < 0) { rw += x; x = 0; }
+  if(y < 0) { rh += y; y = 0; }
+  if(x + rw > w) rw = w - x;
+  if(y + rh > h) rh = h - y;
+  if(rw<=0 || rh<=0) return;
+
+  uint16_t c = SWAP((uint16_t)color);
+  for(int32_t j=y ; j<y+rh ; j++)
+    for(uint16_t *p = buf + j * w + x, *e = p + rw ; p<e ; p++) *p = c;
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color)
+{
+  drawFastHLine(x, y, rw, color);
+  drawFastHLine(x, y + rh - 1, rw, color);
+  drawFastVLine(x, y, rh, color);
+  drawFastVLine(x + rw - 1, y, rh, color);
+}
+
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color)
+{
+  int32_t dx = abs(x1 - x0), sx = x0<x1? 1 : -1;
+  int32_t dy = -abs(y1 - y0), sy = y0<y1? 1 : -1;
+  int32_t err = dx + dy;
+
+  for(;;)
+  {
+    drawPixel(x0, y0, color);
+    if(x0==x1 && y0==y1) break;
+    int32_t e2 = 2 * err;
+    if(e2 >= dy) { err += dy; x0 += sx; }
+    if(e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+//
+// Quarter circles: corners 1, 2, 4, 8 are top left, top right,
+// bottom right, bottom left. Filled quarters are stretched by
+// (dx, dy) to the opposite side of a rounded rectangle.
+//
+void TFT_eSPI::quarterCircle(int32_t x0, int32_t y0, int32_t r, uint8_t corners, int32_t dx, int32_t dy, uint16_t color, bool fill)
+{
+  int32_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+
+  if(fill)
+  {
+    // Rows at the flat edge
+    if(corners & 3) hline(x0 - r, x0 + dx + r, y0, color);
+  }
+
+  while(x < y)
+  {
+    if(f >= 0) { y--; ddy += 2; f += ddy; }
+    x++; ddx += 2; f += ddx;
+
+    if(fill)
+    {
+      if(corners & 1)
+      {
+        hline(x0 - y, x0 + dx + y, y0 - x, color);
+        hline(x0 - x, x0 + dx + x, y0 - y, color);
+      }
+      if(corners & 8)
+      {
+        hline(x0 - y, x0 + dx + y, y0 + dy + x, color);
+        hline(x0 - x, x0 + dx + x, y0 + dy + y, color);
+      }
+    }
+    else
+    {
+      if(corners & 1) { drawPixel(x0 - y, y0 - x, color); drawPixel(x0 - x, y0 - y, color); }
+      if(corners & 2) { drawPixel(x0 + x, y0 - y, color); drawPixel(x0 + y, y0 - x, color); }
+      if(corners & 4) { drawPixel(x0 + x, y0 + y, color); drawPixel(x0 + y, y0 + x, color); }
+      if(corners & 8) { drawPixel(x0 - y, y0 + x, color); drawPixel(x0 - x, y0 + y, color); }
+    }
+  }
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color)
+{
+  r = std::min(r, std::min(rw, rh) / 2);
+  drawFastHLine(x + r, y, rw - 2 * r, color);
+  drawFastHLine(x + r, y + rh - 1, rw - 2 * r, color);
+  drawFastVLine(x, y + r, rh - 2 * r, color);
+  drawFastVLine(x + rw - 1, y + r, rh - 2 * r, color);
+  quarterCircle(x + r, y + r, r, 1, 0, 0, color, false);
+  quarterCircle(x + rw - r - 1, y + r, r, 2, 0, 0, color, false);
+  quarterCircle(x + rw - r - 1, y + rh - r - 1, r, 4, 0, 0, color, false);
+  quarterCircle(x + r, y + rh - r - 1, r, 8, 0, 0, color, false);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color)
+{
+  r = std::min(r, std::min(rw, rh) / 2);
+  fillRect(x, y + r, rw, rh - 2 * r, color);
+  quarterCircle(x + r, y + r, r, 1, rw - 2 * r - 1, 0, color, true);
+  quarterCircle(x + r, y + rh - r - 1, r, 8, rw - 2 * r - 1, 0, color, true);
+}
+
+void TFT_eSPI::fillSmoothRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color, uint32_t bg)
+{
+  fillRoundRect(x, y, rw, rh, r, color);
+}
+
+void TFT_eSPI::drawSmoothRoundRect(int32_t x, int32_t y, int32_t r, int32_t ir, int32_t rw, int32_t rh, uint32_t fg, uint32_t bg, uint8_t quadrants)
+{
+  // Outline r - ir + 1 pixels thick, inside a w x h box
+  for(int32_t i=0 ; i<=r-ir ; i++)
+    drawRoundRect(x + i, y + i, rw - 2 * i, rh - 2 * i, r - i, fg);
+}
+
+void TFT_eSPI::drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color)
+{
+  drawPixel(x0, y0 + r, color);
+  drawPixel(x0, y0 - r, color);
+  drawPixel(x0 + r, y0, color);
+  drawPixel(x0 - r, y0, color);
+  quarterCircle(x0, y0, r, 0xF, 0, 0, color, false);
+}
+
+void TFT_eSPI::fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color)
+{
+  quarterCircle(x0, y0, r, 1, 0, 0, color, true);
+  quarterCircle(x0, y0, r, 8, 0, 0, color, true);
+}
+
+//
+// Arc between ir and r, angles in degrees clockwise from 6 o'clock
+//
+void TFT_eSPI::drawSmoothArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle, uint32_t fg, uint32_t bg, bool roundEnds)
+{
+  for(int32_t dy=-r ; dy<=r ; dy++)
+    for(int32_t dx=-r ; dx<=r ; dx++)
+    {
+      int32_t d2 = dx * dx + dy * dy;
+      if(d2 > r * r + r || d2 < ir * ir - ir) continue;
+
+      double a = atan2(-dx, dy) * 180.0 / M_PI;
+      if(a < 0) a += 360.0;
+      if(a >= startAngle && a <= endAngle) drawPixel(x + dx, y + dy, fg);
+    }
+}
+
+void TFT_eSPI::drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color)
+{
+  drawLine(x0, y0, x1, y1, color);
+  drawLine(x1, y1, x2, y2, color);
+  drawLine(x2, y2, x0, y0, color);
+}
+
+void TFT_eSPI::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color)
+{
+  int32_t a, b, y, last;
+
+  if(y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+  if(y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+  if(y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+
+  if(y0 == y2)
+  {
+    a = std::min(x0, std::min(x1, x2));
+    b = std::max(x0, std::max(x1, x2));
+    hline(a, b, y0, color);
+    return;
+  }
+
+  int32_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0;
+  int32_t dx12 = x2 - x1, dy12 = y2 - y1, sa = 0, sb = 0;
+
+  last = y1==y2? y1 : y1 - 1;
+
+  for(y=y0 ; y<=last ; y++)
+  {
+    a = x0 + sa / dy01;
+    b = x0 + sb / dy02;
+    sa += dx01;
+    sb += dx02;
+    if(a > b) std::swap(a, b);
+    hline(a, b, y, color);
+  }
+
+  sa = dx12 * (y - y1);
+  sb = dx02 * (y - y0);
+  for(; y<=y2 ; y++)
+  {
+    a = x1 + sa / dy12;
+    b = x0 + sb / dy02;
+    sa += dx12;
+    sb += dx02;
+    if(a > b) std::swap(a, b);
+    hline(a, b, y, color);
+  }
+}
+
+//
+// Text
+//
+int16_t TFT_eSPI::fontHeight(uint8_t font)
+{
+  const FontSize *size = fontSize(font, gfxFont);
+
+  if(font==7) return(SEG_HEIGHT);
+  return(size? size->height : 8 * textSize);
+}
+
+int16_t TFT_eSPI::glyphWidth(char c, uint8_t font)
+{
+  const FontSize *size = fontSize(font, gfxFont);
+  int first, count;
+
+  if(font==7)
+  {
+    if(isdigit(c) || c=='-' || c==' ') return(SEG_WIDTH);
+    return(c=='.' || c==':'? SEG_NARROW : 0);
+  }
+
+  if(!size) return(6 * textSize);
+
+  glyphInk(c, &first, &count);
+  return((count * size->scaleNum + size->scaleDen - 1) / size->scaleDen + size->spacing);
+}
+
+int16_t TFT_eSPI::textWidth(const char *string, uint8_t font)
+{
+  int16_t width = 0;
+  while(*string) width += glyphWidth(*string++, font);
+  return(width);
+}
+
+void TFT_eSPI::drawGlyph(char c, int32_t x, int32_t y, uint8_t font)
+{
+  const FontSize *size = fontSize(font, gfxFont);
+  int16_t gw = glyphWidth(c, font);
+  int16_t gh = fontHeight(font);
+
+  if(font==7 && textBg!=textFg && x>=0 && y>=0 && x + gw<=w && y + gh<=h)
+  {
+    int px = 0, py = 0;
+
+    for(uint8_t run : segRle(c, gw))
+      for(int n=(run & 0x7F) + 1 ; n-- ; )
+      {
+        drawPixel(x + px, y + py, run & 0x80? textFg : textBg);
+        if(++px==gw) { px = 0; py++; }
+      }
+    return;
+  }
+
+  // Numbered fonts fill the glyph background
+  if(!gfxFont || font!=1)
+    if(textBg != textFg) fillRect(x, y, gw, gh, textBg);
+
+  if(font==7)
+  {
+    if(isdigit(c))
+    {
+      for(int s=0 ; s<7 ; s++)
+        if(segDigits[c - '0'] & (1 << s))
+          fillRect(x + segRects[s][0], y + segRects[s][1], segRects[s][2], segRects[s][3], textFg);
+    }
+    else if(c=='-')
+      fillRect(x + segRects[6][0], y + segRects[6][1], segRects[6][2], segRects[6][3], textFg);
+    else if(c=='.')
+      fillRect(x + 3, y + SEG_HEIGHT - SEG_T, SEG_T, SEG_T, textFg);
+    else if(c==':')
+    {
+      fillRect(x + 3, y + 14, SEG_T, SEG_T, textFg);
+      fillRect(x + 3, y + 30, SEG_T, SEG_T, textFg);
+    }
+    return;
+  }
+
+  const uint8_t *bits = glyphBits(c);
+  int first, count;
+
+  glyphInk(c, &first, &count);
+
+  if(!size)
+  {
+    // GLCD font, fixed 6x8 cell scaled by text size
+    for(int col=0 ; col<5 ; col++)
+      for(int row=0 ; row<8 ; row++)
+        if(bits[col] & (1 << row))
+          fillRect(x + col * textSize, y + row * textSize, textSize, textSize, textFg);
+    return;
+  }
+
+  // Scaled glyph, vertically centered in the cell
+  int16_t inkW = gw - size->spacing;
+  int16_t top  = y + (size->height - size->glyphHeight) / 2;
+  for(int16_t gy=0 ; gy<size->glyphHeight ; gy++)
+  {
+    uint8_t mask = 1 << (gy * 8 / size->glyphHeight);
+    for(int16_t gx=0 ; gx<inkW ; gx++)
+      if(bits[first + gx * count / inkW] & mask)
+        drawPixel(x + gx, top + gy, textFg);
+  }
+}
+
+int16_t TFT_eSPI::drawString(const char *string, int32_t x, int32_t y, uint8_t font)
+{
+  int16_t width  = textWidth(string, font);
+  int16_t height = fontHeight(font);
+
+  switch(textDatum)
+  {
+    case TC_DATUM: case MC_DATUM: case BC_DATUM: case C_BASELINE: x -= width / 2; break;
+    case TR_DATUM: case MR_DATUM: case BR_DATUM: case R_BASELINE: x -= width; break;
+  }
+
+  switch(textDatum)
+  {
+    case ML_DATUM: case MC_DATUM: case MR_DATUM: y -= height / 2; break;
+    case BL_DATUM: case BC_DATUM: case BR_DATUM: y -= height; break;
+    case L_BASELINE: case C_BASELINE: case R_BASELINE: y -= height * 3 / 4; break;
+  }
+
+  for(; *string ; string++)
+  {
+    drawGlyph(*string, x, y, font);
+    x += glyphWidth(*string, font);
+  }
+
+  return(width);
+}
+
+int16_t TFT_eSPI::drawNumber(long n, int32_t x, int32_t y, uint8_t font)
+{
+  char text[16];
+  sprintf(text, "%ld", n);
+  return(drawString(text, x, y, font));
+}
+
+int16_t TFT_eSPI::drawFloat(float n, uint8_t dp, int32_t x, int32_t y, uint8_t font)
+{
+  char text[32];
+  sprintf(text, "%.*f", dp, n);
+  return(drawString(text, x, y, font));
+}
+
+size_t TFT_eSPI::print(const char *s)
+{
+  size_t n = strlen(s);
+  uint8_t datum = textDatum;
+
+  textDatum = TL_DATUM;
+  for(; *s ; s++)
+  {
+    if(*s=='\n')
+    {
+      cursorX = 0;
+      cursorY += fontHeight(textFont);
+    }
+    else
+    {
+      char c[2] = { *s, 0 };
+      cursorX += drawString(c, cursorX, cursorY, textFont);
+    }
+  }
+
+  textDatum = datum;
+  return(n);
+}
+
+//
+// Sprites
+//
+void *TFT_eSprite::createSprite(int16_t sw, int16_t sh, uint8_t frames)
+{
+  if(buf) return(buf);
+
+  buf = (uint16_t *)calloc(sw * sh, sizeof(uint16_t));
+  w = buf? sw : 0;
+  h = buf? sh : 0;
+  return(buf);
+}
+
+void TFT_eSprite::deleteSprite()
+{
+  free(buf);
+  buf = 0;
+  w = h = 0;
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y)
+{
+  uint16_t *dst = (uint16_t *)tft->getPointer();
+
+  if(!buf || !dst) return;
+
+  for(int32_t j=0 ; j<h ; j++)
+    for(int32_t i=0 ; i<w ; i++)
+      if(x + i>=0 && y + j>=0 && x + i<tft->width() && y + j<tft->height())
+        dst[(y + j) * tft->width() + x + i] = buf[j * w + i];
+}
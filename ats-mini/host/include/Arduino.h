@@ -0,0 +1,163 @@
+//
+// Host build: the parts of the ESP32 Arduino core, ESP-IDF and
+// FreeRTOS used by the firmware, running on a virtual clock
+//
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+using std::abs;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH           1
+#define LOW            0
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define INPUT_PULLUP   0x05
+#define CHANGE         0x03
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define memcpy_P       memcpy
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define digitalPinToInterrupt(pin) (pin)
+#define ps_malloc      malloc
+
+// Not in glibc before 2.38
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+#define HOST_STRLCPY
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+//
+// Virtual clock, only advanced by waiting (delay(), queue timeouts)
+// and by the simulated radio chip. Times are 32 bit, wrapping as on
+// the device.
+//
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+static inline void yield() {}
+
+//
+// GPIO, ADC and PWM
+//
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+//
+// Serial port, fed from the simulation script
+//
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long baud) {}
+    void end() {}
+    int available();
+    int peek();
+    int read();
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t size);
+    size_t write(const char *buf, size_t size) { return(write((const uint8_t *)buf, size)); }
+    size_t write(const char *str) { return(write((const uint8_t *)str, strlen(str))); }
+    size_t printf(const char *format, ...);
+    size_t print(const char *str) { return(write(str)); }
+    size_t print(char c) { return(write((uint8_t)c)); }
+    size_t print(int n) { return(printf("%d", n)); }
+    size_t print(unsigned int n) { return(printf("%u", n)); }
+    size_t print(long n) { return(printf("%ld", n)); }
+    size_t print(unsigned long n) { return(printf("%lu", n)); }
+    size_t print(double n, int digits = 2) { return(printf("%.*f", digits, n)); }
+    template<typename T> size_t println(T x) { return(print(x) + println()); }
+    size_t println() { return(write("\r\n")); }
+    operator bool() const { return(true); }
+};
+
+extern HardwareSerial Serial;
+
+//
+// Chip information
+//
+class EspClass
+{
+  public:
+    uint64_t getEfuseMac() { return(0x0000ABCDEF123456ULL); }
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return(80); }
+    const char *getChipModel() { return("Host"); }
+    uint8_t getChipRevision() { return(0); }
+    uint32_t getFlashChipSize() { return(8 * 1024 * 1024); }
+    uint32_t getFreeSketchSpace() { return(3 * 1024 * 1024); }
+    uint32_t getSketchSize() { return(1536 * 1024); }
+    uint32_t getHeapSize() { return(320 * 1024); }
+    uint32_t getFreeHeap() { return(200 * 1024); }
+    uint32_t getPsramSize() { return(8 * 1024 * 1024); }
+    uint32_t getFreePsram() { return(8 * 1024 * 1024); }
+    void restart() { exit(0); }
+};
+
+extern EspClass ESP;
+
+//
+// ESP-IDF
+//
+typedef int esp_err_t;
+#define ESP_OK         0
+#define ESP_FAIL      -1
+
+typedef int gpio_num_t;
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level);
+esp_err_t esp_light_sleep_start();
+
+//
+// FreeRTOS queues and mutexes, the host build runs a single task
+//
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct HostQueue *QueueHandle_t;
+typedef struct HostQueue *SemaphoreHandle_t;
+typedef int portMUX_TYPE;
+
+#define pdTRUE         1
+#define pdFALSE        0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY  0xFFFFFFFF
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portYIELD_FROM_ISR()
+#define taskENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) { return(pdTRUE); }
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { return(pdTRUE); }
+
+#endif // ARDUINO_H
@@ -0,0 +1,38 @@
+//
+// Host build: web server and WebSockets without clients
+//
+#ifndef ESPASYNCWEBSERVER_H
+#define ESPASYNCWEBSERVER_H
+
+#include <Arduino.h>
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+class AsyncWebSocket;
+class AsyncWebSocketClient {};
+
+typedef void (*AwsEventHandler)(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
+
+class AsyncWebHandler {};
+
+class AsyncWebSocket: public AsyncWebHandler
+{
+  public:
+    AsyncWebSocket(const char *url) {}
+    void onEvent(AwsEventHandler handler) {}
+    size_t count() const { return(0); }
+    void cleanupClients() {}
+    bool availableForWriteAll() { return(true); }
+    void binaryAll(const uint8_t *data, size_t len) {}
+};
+
+class AsyncWebServer
+{
+  public:
+    AsyncWebServer(uint16_t port) {}
+    AsyncWebHandler &addHandler(AsyncWebHandler *handler) { return(*handler); }
+};
+
+#endif // ESPASYNCWEBSERVER_H
@@ -0,0 +1,54 @@
+//
+// Host build: files of the flash file system are host files
+//
+#ifndef FS_H
+#define FS_H
+
+#include <Arduino.h>
+
+namespace fs
+{
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File
+{
+  public:
+    File(FILE *f = 0) : f(f) {}
+    File(const File &) = delete;
+    File(File &&other) : f(other.f) { other.f = 0; }
+    File &operator=(File &&other) { close(); f = other.f; other.f = 0; return(*this); }
+    ~File() { close(); }
+
+    operator bool() const { return(f != 0); }
+    size_t write(const uint8_t *buf, size_t size) { return(f? fwrite(buf, 1, size, f) : 0); }
+    size_t write(uint8_t c) { return(write(&c, 1)); }
+    size_t read(uint8_t *buf, size_t size) { return(f? fread(buf, 1, size, f) : 0); }
+    int read() { return(f? fgetc(f) : -1); }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const { return(f? ftell(f) : 0); }
+    size_t size() const;
+    int available() { return(f? size() - position() : 0); }
+    void flush() { if(f) fflush(f); }
+    void close() { if(f) fclose(f); f = 0; }
+
+  private:
+    FILE *f;
+};
+
+class FS
+{
+  public:
+    File open(const char *path, const char *mode = "r", bool create = false);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+
+  protected:
+    char root[256] = "";
+    void hostPath(char *buf, size_t size, const char *path);
+};
+
+} // namespace fs
+
+#endif // FS_H
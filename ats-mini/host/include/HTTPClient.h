@@ -0,0 +1,32 @@
+//
+// Host build: there is no network, every request fails
+//
+#ifndef HTTPCLIENT_H
+#define HTTPCLIENT_H
+
+#include <Arduino.h>
+
+#define HTTP_CODE_OK 200
+
+class WiFiClient
+{
+  public:
+    int available() { return(0); }
+    int read() { return(-1); }
+};
+
+class HTTPClient
+{
+  public:
+    bool begin(const char *url) { return(false); }
+    int GET() { return(-1); }
+    int getSize() { return(-1); }
+    bool connected() { return(false); }
+    WiFiClient *getStreamPtr() { return(&client); }
+    void end() {}
+
+  private:
+    WiFiClient client;
+};
+
+#endif // HTTPCLIENT_H
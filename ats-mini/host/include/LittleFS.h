@@ -0,0 +1,22 @@
+//
+// Host build: LittleFS is a host directory, "littlefs" under the
+// current directory unless HOST_FS_DIR is set
+//
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+#include <FS.h>
+
+class LittleFSFS: public fs::FS
+{
+  public:
+    bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10, const char *label = "spiffs");
+    void end() { root[0] = '\0'; }
+    bool format();
+    size_t totalBytes() { return(0x200000); }
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // LITTLEFS_H
@@ -0,0 +1,43 @@
+//
+// Host build: preferences kept in memory for the simulation run
+//
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include <Arduino.h>
+
+class Preferences
+{
+  public:
+    bool begin(const char *name, bool readOnly = false, const char *partition = 0);
+    void end() { space[0] = '\0'; }
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putBool(const char *key, bool value) { return(putBytes(key, &value, sizeof(value))); }
+    size_t putUChar(const char *key, uint8_t value) { return(putBytes(key, &value, sizeof(value))); }
+    size_t putUShort(const char *key, uint16_t value) { return(putBytes(key, &value, sizeof(value))); }
+    size_t putULong(const char *key, uint32_t value) { return(putBytes(key, &value, sizeof(value))); }
+    size_t putString(const char *key, const char *value) { return(putBytes(key, value, strlen(value) + 1)); }
+    size_t putBytes(const char *key, const void *value, size_t len);
+
+    bool getBool(const char *key, bool defaultValue = false) { return(get(key, defaultValue)); }
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return(get(key, defaultValue)); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return(get(key, defaultValue)); }
+    uint32_t getULong(const char *key, uint32_t defaultValue = 0) { return(get(key, defaultValue)); }
+    size_t getString(const char *key, char *value, size_t maxLen) { return(getBytes(key, value, maxLen)); }
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+    size_t getBytesLength(const char *key);
+
+  private:
+    char space[16] = "";
+
+    template<typename T> T get(const char *key, T defaultValue)
+    {
+      T value;
+      return(getBytesLength(key)==sizeof(T) && getBytes(key, &value, sizeof(T))? value : defaultValue);
+    }
+};
+
+#endif // PREFERENCES_H
@@ -0,0 +1,234 @@
+//
+// Host build: the PU2CLR SI4735 library interface, backed by a
+// simulated chip. Commands take bus time on the virtual clock, tuning
+// and seeking settle like on the chip, and signal quality and RDS
+// come from a table of stations (see SI4735.cpp).
+//
+#ifndef SI4735_H
+#define SI4735_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define FM_BAND_TYPE          0
+#define MW_BAND_TYPE          1
+#define SW_BAND_TYPE          2
+#define LW_BAND_TYPE          3
+
+#define FM_CURRENT_MODE       0
+#define AM_CURRENT_MODE       1
+#define SSB_CURRENT_MODE      2
+
+#define SI473X_ANALOG_AUDIO   0xB0
+#define XOSCEN_CRYSTAL        1
+#define XOSCEN_RCLK           0
+
+#define SI473X_ADDR_SEN_LOW   0x11
+#define SI473X_ADDR_SEN_HIGH  0x63
+
+typedef union
+{
+  struct
+  {
+    uint8_t FREQL;
+    uint8_t FREQH;
+  } raw;
+  uint16_t value;
+} si47x_frequency;
+
+typedef union
+{
+  struct
+  {
+    uint8_t STCINT : 1;
+    uint8_t DUMMY1 : 1;
+    uint8_t RDSINT : 1;
+    uint8_t RSQINT : 1;
+    uint8_t DUMMY2 : 2;
+    uint8_t ERR : 1;
+    uint8_t CTS : 1;
+    uint8_t VALID : 1;
+    uint8_t AFCRL : 1;
+    uint8_t DUMMY3 : 5;
+    uint8_t BLTF : 1;
+    uint8_t READFREQH;
+    uint8_t READFREQL;
+    uint8_t RSSI;
+    uint8_t SNR;
+    uint8_t MULT;
+    uint8_t READANTCAPH;
+    uint8_t READANTCAPL;
+  } resp;
+  uint8_t raw[8];
+} si47x_response_status;
+
+typedef union
+{
+  struct
+  {
+    uint8_t RSQINT : 1;
+    uint8_t SMUTE : 1;
+    uint8_t DUMMY1 : 1;
+    uint8_t MULTHINT : 1;
+    uint8_t DUMMY2 : 4;
+    uint8_t VALID : 1;
+    uint8_t AFCRL : 1;
+    uint8_t DUMMY3 : 1;
+    uint8_t SMUTE2 : 1;
+    uint8_t DUMMY4 : 4;
+    uint8_t STBLEND : 7;
+    uint8_t PILOT : 1;
+    uint8_t RSSI;
+    uint8_t SNR;
+    uint8_t MULT;
+    uint8_t FREQOFF;
+  } resp;
+  uint8_t raw[8];
+} si47x_rqs_status;
+
+typedef union
+{
+  struct
+  {
+    uint8_t RDSRECV : 1;
+    uint8_t RDSSYNCLOST : 1;
+    uint8_t RDSSYNCFOUND : 1;
+    uint8_t DUMMY1 : 5;
+    uint8_t RDSSYNC : 1;
+    uint8_t DUMMY2 : 1;
+    uint8_t GRPLOST : 1;
+    uint8_t DUMMY3 : 5;
+    uint8_t RDSFIFOUSED;
+    uint8_t BLOCKAH;
+    uint8_t BLOCKAL;
+    uint8_t BLOCKBH;
+    uint8_t BLOCKBL;
+    uint8_t BLOCKCH;
+    uint8_t BLOCKCL;
+    uint8_t BLOCKDH;
+    uint8_t BLOCKDL;
+    uint8_t BLED : 2;
+    uint8_t BLEC : 2;
+    uint8_t BLEB : 2;
+    uint8_t BLEA : 2;
+  } resp;
+  uint8_t raw[13];
+} si47x_rds_status;
+
+typedef union
+{
+  struct
+  {
+    uint8_t PN;
+    uint8_t FWMAJOR;
+    uint8_t FWMINOR;
+    uint8_t RESERVED1;
+    uint8_t RESERVED2;
+    uint8_t CHIPREV;
+    uint8_t LIBRARYID;
+  } resp;
+  uint8_t raw[8];
+} si47x_firmware_query_library;
+
+class SI4735
+{
+  public:
+    SI4735() {}
+
+    // Power up and modes
+    int16_t getDeviceI2CAddress(uint8_t resetPin);
+    void setup(uint8_t resetPin, uint8_t defaultFunction);
+    void setup(uint8_t resetPin, int ctsIntEnable, int defaultFunction, int audioMode = SI473X_ANALOG_AUDIO, uint8_t clockType = XOSCEN_CRYSTAL, uint8_t gpo2Enable = 0);
+    void powerDown();
+    void setFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step);
+    void setAM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step);
+    void setSSB(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step, uint8_t usblsb);
+    void setRefClock(uint16_t refclk) {}
+    void setRefClockPrescaler(uint16_t prescale, uint8_t rclk_sel = 0) {}
+    void setI2CFastModeCustom(long value = 500000) { Wire.setClock(value); }
+    void setAudioMuteMcuPin(int8_t pin) { audioMuteMcuPin = pin; }
+    void setHardwareAudioMute(bool on) { if(audioMuteMcuPin >= 0) digitalWrite(audioMuteMcuPin, on); }
+    bool isCurrentTuneFM() { return(currentTune == 0x20); }
+
+    // Tuning
+    void setFrequency(uint16_t freq);
+    uint16_t getFrequency();
+    uint16_t getCurrentFrequency() { return(currentWorkFrequency); }
+    void setFrequencyStep(uint16_t step) { currentStep = step; }
+    void setMaxDelaySetFrequency(uint16_t value) { maxDelaySetFrequency = value; }
+    void setMaxSeekTime(long value) { maxSeekTime = value; }
+    void seekStation(uint8_t up_down, uint8_t wrap);
+    void getStatus() { getStatus(0, 1); }
+    void getStatus(uint8_t INTACK, uint8_t CANCEL);
+    bool getTuneCompleteTriggered() { return(currentStatus.resp.STCINT); }
+    uint16_t getAntennaTuningCapacitor();
+    void setTuneFrequencyAntennaCapacitor(uint16_t capacitor) {}
+
+    // Signal quality
+    void getCurrentReceivedSignalQuality() { getCurrentReceivedSignalQuality(0); }
+    void getCurrentReceivedSignalQuality(uint8_t INTACK);
+    uint8_t getCurrentRSSI() { return(currentRqsStatus.resp.RSSI); }
+    uint8_t getCurrentSNR() { return(currentRqsStatus.resp.SNR); }
+    bool getCurrentPilot() { return(currentRqsStatus.resp.PILOT); }
+
+    // Properties and commands, all taking bus time
+    void sendProperty(uint16_t propertyNumber, uint16_t parameter);
+    void setVolume(uint8_t volume) { sendProperty(0x4000, volume); }
+    void setFMDeEmphasis(uint8_t parameter) { sendProperty(0x1100, parameter); }
+    void setFmBandwidth(uint8_t filter) { sendCommand(0x2C, 2, 0); }
+    void setBandwidth(uint8_t AMCHFLT, uint8_t AMPLFLT) { sendProperty(0x3102, AMCHFLT | (AMPLFLT << 8)); }
+    void setAvcAmMaxGain(uint8_t gain) { sendProperty(0x3103, gain * 340); }
+    void setAmSoftMuteMaxAttenuation(uint8_t smattn) { sendProperty(0x3302, smattn); }
+    void setSsbSoftMuteMaxAttenuation(uint8_t smattn) { sendProperty(0x3302, smattn); }
+    void setAutomaticGainControl(uint8_t AGCDIS, uint8_t AGCIDX) { sendCommand(isCurrentTuneFM()? 0x28 : 0x48, 3, 0); }
+    void getAutomaticGainControl() { sendCommand(isCurrentTuneFM()? 0x27 : 0x47, 1, 3); }
+    void setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t BLETHC, uint8_t BLETHD);
+    void setSeekFmLimits(uint16_t bottom, uint16_t top) { sendProperty(0x1400, bottom); sendProperty(0x1401, top); }
+    void setSeekFmSpacing(uint16_t spacing) { sendProperty(0x1402, spacing); }
+    void setSeekFmSNRThreshold(uint16_t value) { sendProperty(0x1403, value); }
+    void setSeekFmRssiThreshold(uint16_t value) { sendProperty(0x1404, value); }
+    void setSeekAmLimits(uint16_t bottom, uint16_t top) { sendProperty(0x3400, bottom); sendProperty(0x3401, top); }
+    void setSeekAmSpacing(uint16_t spacing) { sendProperty(0x3402, spacing); }
+    void setSeekAmSNRThreshold(uint16_t value) { sendProperty(0x3403, value); }
+    void setSeekAmRssiThreshold(uint16_t value) { sendProperty(0x3404, value); }
+    void setGpioCtl(uint8_t GPO1OEN, uint8_t GPO2OEN, uint8_t GPO3OEN) { sendCommand(0x80, 1, 0); }
+    void setGpio(uint8_t GPO1LEVEL, uint8_t GPO2LEVEL, uint8_t GPO3LEVEL) { sendCommand(0x81, 1, 0); }
+
+    // SSB
+    void setSSBBfo(int offset) { sendProperty(0x0100, (uint16_t)offset); bfo = offset; }
+    void setSSBConfig(uint8_t AUDIOBW, uint8_t SBCUTFLT, uint8_t AVC_DIVIDER, uint8_t AVCEN, uint8_t SMUTESEL, uint8_t DSP_AFCDIS) { sendProperty(0x0101, AUDIOBW); }
+    void setSSBAudioBandwidth(uint8_t AUDIOBW) { sendProperty(0x0101, AUDIOBW); }
+    void setSSBSidebandCutoffFilter(uint8_t SBCUTFLT) { sendProperty(0x0101, SBCUTFLT); }
+    void setSSBAutomaticVolumeControl(uint8_t AVCEN) { sendProperty(0x0101, AVCEN); }
+    si47x_firmware_query_library queryLibraryId();
+    void patchPowerUp();
+
+    // RDS
+    void getRdsStatus(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY);
+    void getRdsStatus() { getRdsStatus(0, 0, 0); }
+    bool getRdsReceived() { return(currentRdsStatus.resp.RDSRECV); }
+    bool getRdsNewBlockA() { return(true); }
+    uint8_t getRdsVersionCode() { return(currentRdsStatus.resp.BLOCKBH >> 3 & 1); }
+    char *getRdsText2A() { return(0); }
+    char *getRdsText2B() { return(0); }
+
+  protected:
+    int deviceAddress = SI473X_ADDR_SEN_LOW;
+    uint8_t lastMode = FM_CURRENT_MODE;
+    uint8_t currentTune = 0x20;
+    uint16_t currentStep = 10;
+    uint16_t currentWorkFrequency = 0;
+    uint16_t maxDelaySetFrequency = 30;
+    long maxSeekTime = 8000;
+    int8_t audioMuteMcuPin = -1;
+    int bfo = 0;
+
+    si47x_response_status currentStatus = {};
+    si47x_rqs_status currentRqsStatus = {};
+    si47x_rds_status currentRdsStatus = {};
+
+    void waitToSend();
+    void sendCommand(uint8_t cmd, uint8_t args, uint8_t resp);
+};
+
+#endif // SI4735_H
@@ -0,0 +1,179 @@
+//
+// Host build: TFT_eSPI display and sprites backed by in-memory
+// RGB565 buffers. Pixels are stored byte swapped, as in the sprites
+// on the device. Fonts 2, 4 and the free font are drawn with a 5x7
+// font scaled to their sizes, font 7 with real 7-segment digits, so
+// the layout is close to the device but the glyphs are not.
+//
+#ifndef TFT_ESPI_H
+#define TFT_ESPI_H
+
+#include <Arduino.h>
+
+// Text datums
+#define TL_DATUM        0
+#define TC_DATUM        1
+#define TR_DATUM        2
+#define ML_DATUM        3
+#define CL_DATUM        3
+#define MC_DATUM        4
+#define CC_DATUM        4
+#define MR_DATUM        5
+#define CR_DATUM        5
+#define BL_DATUM        6
+#define BC_DATUM        7
+#define BR_DATUM        8
+#define L_BASELINE      9
+#define C_BASELINE     10
+#define R_BASELINE     11
+
+// Colors
+#define TFT_BLACK      0x0000
+#define TFT_NAVY       0x000F
+#define TFT_DARKGREEN  0x03E0
+#define TFT_DARKCYAN   0x03EF
+#define TFT_MAROON     0x7800
+#define TFT_PURPLE     0x780F
+#define TFT_OLIVE      0x7BE0
+#define TFT_LIGHTGREY  0xD69A
+#define TFT_DARKGREY   0x7BEF
+#define TFT_BLUE       0x001F
+#define TFT_GREEN      0x07E0
+#define TFT_CYAN       0x07FF
+#define TFT_RED        0xF800
+#define TFT_MAGENTA    0xF81F
+#define TFT_YELLOW     0xFFE0
+#define TFT_WHITE      0xFFFF
+#define TFT_ORANGE     0xFDA0
+#define TFT_GREENYELLOW 0xB7E0
+#define TFT_PINK       0xFE19
+#define TFT_BROWN      0x9A60
+#define TFT_GOLD       0xFEA0
+#define TFT_SILVER     0xC618
+#define TFT_SKYBLUE    0x867D
+#define TFT_VIOLET     0x915C
+#define TFT_TRANSPARENT 0x0120
+
+// ST7789 commands and MADCTL bits
+#define ST7789_SLPIN   0x10
+#define ST7789_SLPOUT  0x11
+#define ST7789_DISPOFF 0x28
+#define ST7789_DISPON  0x29
+#define ST7789_RDDID   0x04
+#define ST7789_RDDST   0x09
+#define TFT_MADCTL     0x36
+#define TFT_MAD_MY     0x80
+#define TFT_MAD_MX     0x40
+#define TFT_MAD_MV     0x20
+#define TFT_MAD_BGR    0x08
+
+// Sprite attributes
+#define PSRAM_ENABLE   3
+
+// Free font, only its size is used
+typedef struct
+{
+  uint8_t yAdvance;
+} GFXfont;
+
+extern const GFXfont Orbitron_Light_24;
+
+class TFT_eSPI
+{
+  public:
+    TFT_eSPI(int16_t w = 170, int16_t h = 320);
+    TFT_eSPI(const TFT_eSPI &) = delete;
+    virtual ~TFT_eSPI();
+
+    void begin() {}
+    void init() {}
+    void setRotation(uint8_t r);
+    void invertDisplay(bool i) {}
+    void writecommand(uint8_t c);
+    void writedata(uint8_t d) {}
+    uint8_t readcommand8(uint8_t cmd, uint8_t index = 0) { return(0); }
+    uint32_t readcommand32(uint8_t cmd, uint8_t index = 0) { return(0); }
+    bool displayOn() const { return(dispOn); }
+
+    int16_t width() const { return(w); }
+    int16_t height() const { return(h); }
+
+    // Graphics primitives
+    void fillScreen(uint32_t color) { fillRect(0, 0, w, h, color); }
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t len, uint32_t color) { fillRect(x, y, len, 1, color); }
+    void drawFastVLine(int32_t x, int32_t y, int32_t len, uint32_t color) { fillRect(x, y, 1, len, color); }
+    void drawRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color);
+    void fillSmoothRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color, uint32_t bg = 0x00FFFFFF);
+    void drawSmoothRoundRect(int32_t x, int32_t y, int32_t r, int32_t ir, int32_t rw, int32_t rh, uint32_t fg, uint32_t bg = 0x00FFFFFF, uint8_t quadrants = 0xF);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void drawSmoothArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle, uint32_t fg, uint32_t bg, bool roundEnds = false);
+    void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+    uint16_t readPixel(int32_t x, int32_t y);
+
+    // Text
+    void setTextColor(uint16_t fg) { textFg = textBg = fg; }
+    void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false) { textFg = fg; textBg = bg; }
+    void setTextDatum(uint8_t d) { textDatum = d; }
+    uint8_t getTextDatum() const { return(textDatum); }
+    void setTextSize(uint8_t s) { textSize = s? s : 1; }
+    void setTextFont(uint8_t f) { textFont = f; gfxFont = 0; }
+    void setFreeFont(const GFXfont *f) { textFont = 1; gfxFont = f; }
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setSwapBytes(bool swap) {}
+    int16_t textWidth(const char *string, uint8_t font);
+    int16_t textWidth(const char *string) { return(textWidth(string, textFont)); }
+    int16_t fontHeight(uint8_t font);
+    int16_t fontHeight() { return(fontHeight(textFont)); }
+    int16_t drawString(const char *string, int32_t x, int32_t y, uint8_t font);
+    int16_t drawString(const char *string, int32_t x, int32_t y) { return(drawString(string, x, y, textFont)); }
+    int16_t drawNumber(long n, int32_t x, int32_t y, uint8_t font);
+    int16_t drawNumber(long n, int32_t x, int32_t y) { return(drawNumber(n, x, y, textFont)); }
+    int16_t drawFloat(float n, uint8_t dp, int32_t x, int32_t y, uint8_t font);
+    int16_t drawFloat(float n, uint8_t dp, int32_t x, int32_t y) { return(drawFloat(n, dp, x, y, textFont)); }
+    size_t print(const char *s);
+    size_t println(const char *s) { return(print(s) + print("\n")); }
+    size_t println() { return(print("\n")); }
+
+    // Raw pixels, byte swapped RGB565
+    void *getPointer() { return(buf); }
+
+  protected:
+    uint16_t *buf;
+    int16_t w, h;
+    bool dispOn;
+
+    uint16_t textFg, textBg;
+    uint8_t textDatum, textSize, textFont;
+    const GFXfont *gfxFont;
+    int16_t cursorX, cursorY;
+
+    void hline(int32_t x0, int32_t x1, int32_t y, uint16_t color);
+    void quarterCircle(int32_t x, int32_t y, int32_t r, uint8_t corners, int32_t dx, int32_t dy, uint16_t color, bool fill);
+    int16_t glyphWidth(char c, uint8_t font);
+    void drawGlyph(char c, int32_t x, int32_t y, uint8_t font);
+};
+
+class TFT_eSprite: public TFT_eSPI
+{
+  public:
+    TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0), tft(tft) {}
+
+    void *createSprite(int16_t sw, int16_t sh, uint8_t frames = 1);
+    void deleteSprite();
+    bool created() const { return(buf != 0); }
+    void setAttribute(uint8_t attr, uint8_t value) {}
+    void fillSprite(uint32_t color) { fillRect(0, 0, w, h, color); }
+    void pushSprite(int32_t x, int32_t y);
+
+  private:
+    TFT_eSPI *tft;
+};
+
+#endif // TFT_ESPI_H
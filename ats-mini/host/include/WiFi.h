@@ -0,0 +1,9 @@
+//
+// Host build: there is no network
+//
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+
+#endif // WIFI_H
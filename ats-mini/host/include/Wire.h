@@ -0,0 +1,36 @@
+//
+// Host build: I2C bus to the simulated radio chip, the only device
+// on it. Transfers take bus time on the virtual clock.
+//
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire
+{
+  public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return(true); }
+    bool setClock(uint32_t frequency) { clock = frequency; return(true); }
+    uint32_t getClock() const { return(clock); }
+
+    void beginTransmission(uint8_t address) { written = 0; }
+    size_t write(uint8_t data) { written++; return(1); }
+    size_t write(const uint8_t *data, size_t size) { written += size; return(size); }
+    uint8_t endTransmission(bool stop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t size, bool stop = true);
+    int available() { return(pending); }
+    int read();
+
+    // Time taken by a transfer of the given size (us)
+    uint32_t busTime(size_t bytes) const { return((bytes + 1) * 9 * 1000000ULL / clock); }
+
+  private:
+    uint32_t clock = 100000;
+    size_t written = 0;
+    uint8_t pending = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
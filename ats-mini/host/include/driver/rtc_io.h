@@ -0,0 +1,14 @@
+//
+// Host build: RTC GPIO, only used to wake up from the light sleep
+//
+#ifndef DRIVER_RTC_IO_H
+#define DRIVER_RTC_IO_H
+
+#include <Arduino.h>
+
+static inline esp_err_t rtc_gpio_pullup_en(gpio_num_t pin) { return(ESP_OK); }
+static inline esp_err_t rtc_gpio_pullup_dis(gpio_num_t pin) { return(ESP_OK); }
+static inline esp_err_t rtc_gpio_pulldown_dis(gpio_num_t pin) { return(ESP_OK); }
+static inline esp_err_t rtc_gpio_deinit(gpio_num_t pin) { return(ESP_OK); }
+
+#endif // DRIVER_RTC_IO_H
@@ -0,0 +1,19 @@
+//
+// Host build: NVS is kept in memory, see Preferences.h
+//
+#ifndef NVS_H
+#define NVS_H
+
+#include <Arduino.h>
+
+typedef struct
+{
+  uint32_t used_entries;
+  uint32_t free_entries;
+  uint32_t total_entries;
+  uint32_t namespace_count;
+} nvs_stats_t;
+
+esp_err_t nvs_get_stats(const char *partition, nvs_stats_t *stats);
+
+#endif // NVS_H
@@ -0,0 +1,14 @@
+//
+// Host build: erasing NVS drops all in-memory preferences
+//
+#ifndef NVS_FLASH_H
+#define NVS_FLASH_H
+
+#include <Arduino.h>
+
+esp_err_t nvs_flash_erase();
+esp_err_t nvs_flash_erase_partition(const char *partition);
+static inline esp_err_t nvs_flash_init() { return(ESP_OK); }
+static inline esp_err_t nvs_flash_init_partition(const char *partition) { return(ESP_OK); }
+
+#endif // NVS_FLASH_H
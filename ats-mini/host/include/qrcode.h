@@ -0,0 +1,25 @@
+//
+// Host build: draws a fixed pattern derived from the text instead
+// of a real QR code, which is enough to check the screen layout
+//
+#ifndef QRCODE_H
+#define QRCODE_H
+
+#include <stdint.h>
+
+typedef const uint8_t *esp_qrcode_handle_t;
+
+typedef struct
+{
+  void (*display_func)(esp_qrcode_handle_t qrcode);
+  int max_qrcode_version;
+  int qrcode_ecc_level;
+} esp_qrcode_config_t;
+
+#define ESP_QRCODE_CONFIG_DEFAULT() { 0, 10, 1 }
+
+int esp_qrcode_get_size(esp_qrcode_handle_t qrcode);
+bool esp_qrcode_get_module(esp_qrcode_handle_t qrcode, int x, int y);
+int esp_qrcode_generate(esp_qrcode_config_t *cfg, const char *text);
+
+#endif // QRCODE_H